@@ -0,0 +1,210 @@
+#include "arena.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+namespace {
+
+constexpr size_t kAlign = 64;
+// 每个线程的 arena 最多向系统申请的字节数，超出的请求退回默认分配器
+constexpr size_t kMaxArenaBytes = size_t{512} << 20;
+constexpr size_t kMinChunkBytes = size_t{1} << 20;
+
+std::atomic<size_t> gPeakBytes{0};
+std::atomic<size_t> gReservedBytes{0};
+std::atomic<unsigned long long> gFallbacks{0};
+
+size_t alignUp(size_t n) { return (n + kAlign - 1) & ~(kAlign - 1); }
+
+/**
+ * 单个线程的顺序分配区，由若干块系统内存组成
+ * 只有所属线程分配；释放可以来自任何线程，因此存活计数是原子的。
+ * 计数中包含所属线程自身的1个引用，线程退出后由最后一个释放者删除
+ */
+class Arena {
+public:
+  ~Arena() {
+    for (chunk &c : chunks_) {
+      std::free(c.data);
+    }
+    gReservedBytes.fetch_sub(capacity_, std::memory_order_relaxed);
+  }
+
+  /**
+   * 分配 bytes 字节(按64字节对齐)，超出上限或内存不足时返回空
+   */
+  void *allocate(size_t bytes) {
+    bytes = alignUp(bytes);
+    if (refs_.load(std::memory_order_acquire) == 1 && used_ > 0) {
+      reset();
+    }
+
+    while (current_ < chunks_.size()) {
+      chunk &c = chunks_[current_];
+      if (offset_ + bytes <= c.size) {
+        return take(c.data + offset_, bytes);
+      }
+      current_++;
+      offset_ = 0;
+    }
+
+    size_t size = std::max({bytes, kMinChunkBytes, capacity_});
+    size = std::min(size, kMaxArenaBytes - capacity_);
+    if (size < bytes || !grow(size)) {
+      return nullptr;
+    }
+    return take(chunks_.back().data, bytes);
+  }
+
+  /**
+   * 释放一次分配，或所属线程退出时释放自身的引用
+   */
+  void release() {
+    if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      delete this;
+    }
+  }
+
+private:
+  struct chunk {
+    unsigned char *data;
+    size_t size;
+  };
+
+  void *take(unsigned char *p, size_t bytes) {
+    offset_ += bytes;
+    used_ += bytes;
+    refs_.fetch_add(1, std::memory_order_relaxed);
+    size_t peak = gPeakBytes.load(std::memory_order_relaxed);
+    while (used_ > peak && !gPeakBytes.compare_exchange_weak(
+                               peak, used_, std::memory_order_relaxed)) {
+    }
+    return p;
+  }
+
+  bool grow(size_t size) {
+    auto data = static_cast<unsigned char *>(std::malloc(size));
+    if (data == nullptr) {
+      return false;
+    }
+    gFallbacks.fetch_add(1, std::memory_order_relaxed);
+    gReservedBytes.fetch_add(size, std::memory_order_relaxed);
+    chunks_.push_back(chunk{data, size});
+    capacity_ += size;
+    current_ = chunks_.size() - 1;
+    offset_ = 0;
+    return true;
+  }
+
+  /**
+   * 没有存活的分配时从头复用；上一轮用到了多块内存时合并为一块，
+   * 使同样的请求序列下一轮在一块内完成
+   */
+  void reset() {
+    if (chunks_.size() > 1) {
+      size_t total = capacity_;
+      for (chunk &c : chunks_) {
+        std::free(c.data);
+      }
+      chunks_.clear();
+      gReservedBytes.fetch_sub(capacity_, std::memory_order_relaxed);
+      capacity_ = 0;
+      grow(total);
+    }
+    current_ = 0;
+    offset_ = 0;
+    used_ = 0;
+  }
+
+  std::vector<chunk> chunks_;
+  size_t current_{0};
+  size_t offset_{0};
+  size_t used_{0};
+  size_t capacity_{0};
+  std::atomic<int> refs_{1};
+};
+
+/**
+ * 线程退出时交出所属线程的引用
+ */
+struct arenaHolder {
+  Arena *arena{new Arena};
+  ~arenaHolder() { arena->release(); }
+};
+
+Arena &threadArena() {
+  thread_local arenaHolder holder;
+  return *holder.arena;
+}
+
+class ArenaMatAllocator : public cv::MatAllocator {
+public:
+  cv::UMatData *allocate(int dims, int const *sizes, int type, void *data0,
+                         size_t *step, cv::AccessFlag flags,
+                         cv::UMatUsageFlags usage) const override {
+    cv::MatAllocator *fallback = cv::Mat::getStdAllocator();
+    if (data0 != nullptr) {
+      return fallback->allocate(dims, sizes, type, data0, step, flags, usage);
+    }
+
+    // 与 OpenCV 默认分配器相同的连续布局
+    size_t total = CV_ELEM_SIZE(type);
+    for (int i = dims - 1; i >= 0; i--) {
+      if (step != nullptr) {
+        step[i] = total;
+      }
+      total *= sizes[i];
+    }
+
+    size_t header = alignUp(sizeof(cv::UMatData));
+    Arena &arena = threadArena();
+    void *p = arena.allocate(header + total);
+    if (p == nullptr) {
+      gFallbacks.fetch_add(1, std::memory_order_relaxed);
+      return fallback->allocate(dims, sizes, type, data0, step, flags, usage);
+    }
+    auto *u = new (p) cv::UMatData(this);
+    u->data = u->origdata = static_cast<uchar *>(p) + header;
+    u->size = total;
+    u->userdata = &arena;
+    return u;
+  }
+
+  bool allocate(cv::UMatData *u, cv::AccessFlag,
+                cv::UMatUsageFlags) const override {
+    return u != nullptr;
+  }
+
+  void deallocate(cv::UMatData *u) const override {
+    if (u == nullptr) {
+      return;
+    }
+    CV_Assert(u->urefcount == 0 && u->refcount == 0);
+    auto *arena = static_cast<Arena *>(u->userdata);
+    u->~UMatData();
+    arena->release();
+  }
+};
+
+} // namespace
+
+cv::MatAllocator *arenaAllocator() {
+  static ArenaMatAllocator instance;
+  return &instance;
+}
+
+arenaCounters arenaStats() {
+  return arenaCounters{gPeakBytes.load(std::memory_order_relaxed),
+                       gReservedBytes.load(std::memory_order_relaxed),
+                       gFallbacks.load(std::memory_order_relaxed)};
+}
+
+void resetArenaStats() {
+  gPeakBytes.store(0, std::memory_order_relaxed);
+  gFallbacks.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,36 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+
+namespace cv {
+class MatAllocator;
+}
+
+/**
+ * 临时图像的分配器：数据和 UMatData 都从调用线程的 arena 中顺序分配，
+ * 释放时只计数；线程的 arena 中不再有存活的图像时(即每次调用结束后)，
+ * 下一次分配从头复用，稳态下不再调用系统分配器
+ * 用法: cv::Mat tmp; tmp.allocator = arenaAllocator(); tmp.create(...);
+ * 只用于在一次调用内创建并释放的临时图像，返回给调用方的图像不能使用；
+ * 图像可以在其他线程释放，arena 超出上限时退回到 OpenCV 的默认分配器
+ */
+cv::MatAllocator *arenaAllocator();
+
+/**
+ * arena 的统计，见 interface.h 中的 arena_stats
+ */
+struct arenaCounters {
+  size_t peakBytes;
+  size_t reservedBytes;
+  unsigned long long fallbacks;
+};
+
+arenaCounters arenaStats();
+
+/**
+ * 清零 peakBytes 和 fallbacks
+ */
+void resetArenaStats();
+
+#endif // ARENA_H
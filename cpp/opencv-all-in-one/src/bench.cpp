@@ -0,0 +1,474 @@
+#include <interface.h>
+
+#include "ops.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+/**
+ * mylib 性能测试
+ * 运行: mylib_bench [--out 结果.json] [--sizes vga,1080p] [--values 0,75]
+ *                   [--threads 1,8] [--ops sharpen,processrgb] [--min-time ms]
+ * 比较: mylib_bench --compare 基准.json 新结果.json [--threshold 百分比]
+ */
+
+struct resolution {
+  char const *name;
+  int width;
+  int height;
+};
+
+static resolution const kResolutions[] = {
+    {"vga", 640, 480},  {"720p", 1280, 720}, {"1080p", 1920, 1080},
+    {"4k", 3840, 2160}, {"8k", 7680, 4320},
+};
+
+using opFn = std::function<void(cv::Mat const &, int)>;
+
+struct benchOp {
+  char const *name;
+  opFn run;
+};
+
+/**
+ * processrgb 端到端: 包括输出缓冲区的分配、拷贝与归还
+ */
+static opFn processrgbOp(int type) {
+  return [type](cv::Mat const &img, int value) {
+    int w, h, stride;
+    unsigned char *out = nullptr;
+    processrgb(param{type, value}, img.data, img.cols, img.rows,
+               static_cast<int>(img.step[0]), &w, &h, &stride, &out);
+    release_rgb(out);
+  };
+}
+
+/**
+ * 缩放的 value 是百分比，没有0；--values 里的0按1%处理
+ */
+static int resamplePercent(int value) { return std::clamp(value, 1, 400); }
+
+static std::vector<benchOp> allOps() {
+  return {
+      {"sharpen", [](cv::Mat const &img, int v) { sharpen(img, v); }},
+      {"sharpen_fixed",
+       [](cv::Mat const &img, int v) { sharpen(img, v, true); }},
+      {"contrast", [](cv::Mat const &img, int v) { adjustContrast(img, v); }},
+      {"saturation",
+       [](cv::Mat const &img, int v) { adjustSaturation(img, v); }},
+      {"brightness",
+       [](cv::Mat const &img, int v) { adjustBrightness(img, v); }},
+      {"auto_levels", [](cv::Mat const &img, int v) { autoLevels(img, v); }},
+      {"denoise", [](cv::Mat const &img, int v) { denoise(img, v); }},
+      {"resample",
+       [](cv::Mat const &img, int v) { resample(img, resamplePercent(v)); }},
+      {"processrgb/sharpen", processrgbOp(0)},
+      {"processrgb/sharpen_fixed", processrgbOp(0 | PARAM_FIXED_POINT)},
+      {"processrgb/contrast", processrgbOp(1)},
+      {"processrgb/saturation", processrgbOp(2)},
+      {"processrgb/brightness", processrgbOp(3)},
+      {"processrgb/auto_levels", processrgbOp(4)},
+      {"processrgb/denoise", processrgbOp(5)},
+      {"processrgb/resample",
+       [](cv::Mat const &img, int v) {
+         processrgbOp(6)(img, resamplePercent(v));
+       }},
+  };
+}
+
+struct benchResult {
+  std::string op;
+  std::string resolution;
+  int width;
+  int height;
+  int value;
+  int threads;
+  int iterations;
+  double medianMs;
+  double p95Ms;
+  double mbPerSec;
+};
+
+struct options {
+  std::string out;
+  std::vector<std::string> sizes;
+  std::vector<int> values{0, 25, 75, 100};
+  std::vector<int> threads;
+  std::vector<std::string> ops;
+  double minTimeMs{300};
+  int minIters{5};
+  int maxIters{200};
+  std::string compareBase;
+  std::string compareNew;
+  double threshold{10};
+};
+
+static std::vector<std::string> splitList(std::string const &text) {
+  std::vector<std::string> items;
+  std::stringstream ss(text);
+  for (std::string item; std::getline(ss, item, ',');) {
+    if (!item.empty()) {
+      items.push_back(item);
+    }
+  }
+  return items;
+}
+
+static std::vector<int> splitInts(std::string const &text) {
+  std::vector<int> items;
+  for (std::string const &item : splitList(text)) {
+    items.push_back(std::atoi(item.c_str()));
+  }
+  return items;
+}
+
+/**
+ * 一组样本的第 q 分位数(最近秩法)
+ */
+static double percentile(std::vector<double> sorted, double q) {
+  std::sort(sorted.begin(), sorted.end());
+  size_t rank = static_cast<size_t>(std::ceil(q * sorted.size()));
+  return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+/**
+ * 先预热一次，再重复执行直到同时满足最少次数和最短时间(或达到最多次数)
+ */
+static benchResult measure(benchOp const &op, cv::Mat const &img,
+                           resolution const &res, int value, int threads,
+                           options const &opt) {
+  using clock = std::chrono::steady_clock;
+  op.run(img, value);
+
+  std::vector<double> samples;
+  auto start = clock::now();
+  while (static_cast<int>(samples.size()) < opt.maxIters) {
+    auto t0 = clock::now();
+    op.run(img, value);
+    auto t1 = clock::now();
+    using ms = std::chrono::duration<double, std::milli>;
+    samples.push_back(ms(t1 - t0).count());
+    double elapsed = ms(t1 - start).count();
+    if (static_cast<int>(samples.size()) >= opt.minIters &&
+        elapsed >= opt.minTimeMs) {
+      break;
+    }
+  }
+
+  benchResult r;
+  r.op = op.name;
+  r.resolution = res.name;
+  r.width = res.width;
+  r.height = res.height;
+  r.value = value;
+  r.threads = threads;
+  r.iterations = static_cast<int>(samples.size());
+  r.medianMs = percentile(samples, 0.5);
+  r.p95Ms = percentile(samples, 0.95);
+  double mb = res.width * static_cast<double>(res.height) * 3 / 1e6;
+  r.mbPerSec = mb / (r.medianMs / 1e3);
+  return r;
+}
+
+static void writeJson(std::ostream &os,
+                      std::vector<benchResult> const &results) {
+  static char const *const levels[] = {"baseline", "sse42", "avx2", "avx512"};
+  os << "{\n  \"opencv\": \"" << CV_VERSION << "\",\n"
+     << "  \"cpu_level\": \"" << levels[get_cpu_level()] << "\",\n"
+     << "  \"hardware_threads\": " << std::thread::hardware_concurrency()
+     << ",\n  \"results\": [\n";
+  char line[512];
+  for (size_t i = 0; i < results.size(); i++) {
+    benchResult const &r = results[i];
+    std::snprintf(line, sizeof(line),
+                  "    {\"op\": \"%s\", \"resolution\": \"%s\", \"width\": %d, "
+                  "\"height\": %d, \"value\": %d, \"threads\": %d, "
+                  "\"iterations\": %d, \"median_ms\": %.4f, \"p95_ms\": %.4f, "
+                  "\"mb_per_s\": %.2f}%s\n",
+                  r.op.c_str(), r.resolution.c_str(), r.width, r.height,
+                  r.value, r.threads, r.iterations, r.medianMs, r.p95Ms,
+                  r.mbPerSec, i + 1 < results.size() ? "," : "");
+    os << line;
+  }
+  os << "  ]\n}\n";
+}
+
+/**
+ * 只支持本程序输出用到的 JSON 子集: 对象、数组、字符串(无转义)和数字
+ */
+class jsonReader {
+public:
+  explicit jsonReader(std::string text) : text_(std::move(text)) {}
+
+  /**
+   * 读出 results 数组中的每个对象，字段值统一保存为字符串
+   */
+  bool results(std::vector<std::map<std::string, std::string>> &out) {
+    size_t key = text_.find("\"results\"");
+    if (key == std::string::npos) {
+      return false;
+    }
+    pos_ = text_.find('[', key);
+    if (pos_ == std::string::npos) {
+      return false;
+    }
+    pos_++;
+    while (true) {
+      skipSpace();
+      if (peek() == ']') {
+        return true;
+      }
+      std::map<std::string, std::string> obj;
+      if (!object(obj)) {
+        return false;
+      }
+      out.push_back(std::move(obj));
+      skipSpace();
+      if (peek() == ',') {
+        pos_++;
+      }
+    }
+  }
+
+private:
+  char peek() const { return pos_ < text_.size() ? text_[pos_] : '\0'; }
+
+  void skipSpace() {
+    while (pos_ < text_.size() &&
+           std::isspace(static_cast<unsigned char>(text_[pos_]))) {
+      pos_++;
+    }
+  }
+
+  bool string(std::string &out) {
+    skipSpace();
+    if (peek() != '"') {
+      return false;
+    }
+    size_t end = text_.find('"', pos_ + 1);
+    if (end == std::string::npos) {
+      return false;
+    }
+    out = text_.substr(pos_ + 1, end - pos_ - 1);
+    pos_ = end + 1;
+    return true;
+  }
+
+  bool scalar(std::string &out) {
+    skipSpace();
+    if (peek() == '"') {
+      return string(out);
+    }
+    size_t begin = pos_;
+    while (pos_ < text_.size() &&
+           std::strchr("+-.eE0123456789", text_[pos_]) != nullptr) {
+      pos_++;
+    }
+    out = text_.substr(begin, pos_ - begin);
+    return !out.empty();
+  }
+
+  bool object(std::map<std::string, std::string> &out) {
+    skipSpace();
+    if (peek() != '{') {
+      return false;
+    }
+    pos_++;
+    while (true) {
+      skipSpace();
+      if (peek() == '}') {
+        pos_++;
+        return true;
+      }
+      std::string key, value;
+      if (!string(key)) {
+        return false;
+      }
+      skipSpace();
+      if (peek() != ':') {
+        return false;
+      }
+      pos_++;
+      if (!scalar(value)) {
+        return false;
+      }
+      out[key] = value;
+      skipSpace();
+      if (peek() == ',') {
+        pos_++;
+      }
+    }
+  }
+
+  std::string text_;
+  size_t pos_{0};
+};
+
+static bool loadResults(std::string const &path,
+                        std::map<std::string, double> &medians) {
+  std::ifstream in(path);
+  if (!in) {
+    std::cerr << "无法读取 " << path << std::endl;
+    return false;
+  }
+  std::stringstream ss;
+  ss << in.rdbuf();
+  std::vector<std::map<std::string, std::string>> rows;
+  if (!jsonReader(ss.str()).results(rows)) {
+    std::cerr << "无法解析 " << path << std::endl;
+    return false;
+  }
+  for (auto &row : rows) {
+    std::string key = row["op"] + " " + row["width"] + "x" + row["height"] +
+                      " v" + row["value"] + " t" + row["threads"];
+    medians[key] = std::atof(row["median_ms"].c_str());
+  }
+  return true;
+}
+
+/**
+ * 按 op、分辨率、参数和线程数对齐两份结果，中位数变慢超过阈值即为回归
+ * @return 存在回归时返回1
+ */
+static int compare(options const &opt) {
+  std::map<std::string, double> base, cur;
+  if (!loadResults(opt.compareBase, base) ||
+      !loadResults(opt.compareNew, cur)) {
+    return 2;
+  }
+
+  int regressions = 0;
+  std::printf("%-44s %10s %10s %8s\n", "case", "base_ms", "new_ms", "change");
+  for (auto const &[key, ms] : cur) {
+    auto it = base.find(key);
+    if (it == base.end()) {
+      std::printf("%-44s %10s %10.3f %8s\n", key.c_str(), "-", ms, "new");
+      continue;
+    }
+    double change = (ms / it->second - 1) * 100;
+    bool regressed = change > opt.threshold;
+    regressions += regressed;
+    std::printf("%-44s %10.3f %10.3f %+7.1f%%%s\n", key.c_str(), it->second,
+                ms, change, regressed ? "  REGRESSION" : "");
+  }
+  for (auto const &[key, ms] : base) {
+    if (cur.find(key) == cur.end()) {
+      std::printf("%-44s %10.3f %10s %8s\n", key.c_str(), ms, "-", "missing");
+    }
+  }
+  std::printf("\n%d 项回归(阈值 %.1f%%)\n", regressions, opt.threshold);
+  return regressions > 0 ? 1 : 0;
+}
+
+static bool parseArgs(int argc, char **argv, options &opt) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    char const *v = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (arg == "--compare" && i + 2 < argc) {
+      opt.compareBase = argv[++i];
+      opt.compareNew = argv[++i];
+      continue;
+    }
+    if (v == nullptr) {
+      std::cerr << "无效的参数: " << arg << std::endl;
+      return false;
+    }
+    i++;
+    if (arg == "--out") {
+      opt.out = v;
+    } else if (arg == "--sizes") {
+      opt.sizes = splitList(v);
+    } else if (arg == "--values") {
+      opt.values = splitInts(v);
+    } else if (arg == "--threads") {
+      opt.threads = splitInts(v);
+    } else if (arg == "--ops") {
+      opt.ops = splitList(v);
+    } else if (arg == "--min-time") {
+      opt.minTimeMs = std::atof(v);
+    } else if (arg == "--min-iters") {
+      opt.minIters = std::max(1, std::atoi(v));
+    } else if (arg == "--max-iters") {
+      opt.maxIters = std::max(1, std::atoi(v));
+    } else if (arg == "--threshold") {
+      opt.threshold = std::atof(v);
+    } else {
+      std::cerr << "无效的参数: " << arg << std::endl;
+      return false;
+    }
+  }
+  if (opt.threads.empty()) {
+    opt.threads = {1};
+    int hw = static_cast<int>(std::thread::hardware_concurrency());
+    if (hw > 1) {
+      opt.threads.push_back(hw);
+    }
+  }
+  return true;
+}
+
+static bool selected(std::vector<std::string> const &filter,
+                     std::string const &name) {
+  return filter.empty() ||
+         std::find(filter.begin(), filter.end(), name) != filter.end();
+}
+
+int main(int argc, char **argv) {
+  options opt;
+  if (!parseArgs(argc, argv, opt)) {
+    return 2;
+  }
+  if (!opt.compareBase.empty()) {
+    return compare(opt);
+  }
+
+  std::vector<benchOp> ops = allOps();
+  std::vector<benchResult> results;
+  for (resolution const &res : kResolutions) {
+    if (!selected(opt.sizes, res.name)) {
+      continue;
+    }
+    // 合成图像: 随机噪声，无需测试素材；各算子的耗时与内容无关
+    cv::Mat img(res.height, res.width, CV_8UC3);
+    cv::randu(img, cv::Scalar(0, 0, 0), cv::Scalar(256, 256, 256));
+
+    for (int threads : opt.threads) {
+      set_num_threads(threads);
+      for (benchOp const &op : ops) {
+        if (!selected(opt.ops, op.name)) {
+          continue;
+        }
+        for (int value : opt.values) {
+          benchResult r = measure(op, img, res, value, threads, opt);
+          std::fprintf(stderr, "%-22s %-6s v%-3d t%-3d %9.3f ms %9.1f MB/s\n",
+                       r.op.c_str(), r.resolution.c_str(), r.value, r.threads,
+                       r.medianMs, r.mbPerSec);
+          results.push_back(r);
+        }
+      }
+    }
+  }
+
+  if (opt.out.empty()) {
+    writeJson(std::cout, results);
+  } else {
+    std::ofstream out(opt.out);
+    writeJson(out, results);
+  }
+  return 0;
+}
@@ -0,0 +1,71 @@
+#include "fast_blur.h"
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+/**
+ * 没有指定输入图像时使用的合成图像：正弦纹理、棋盘格边缘和噪声
+ */
+static cv::Mat syntheticImage(int width, int height) {
+  cv::Mat img(height, width, CV_8UC3);
+  cv::RNG rng(7);
+  for (int y = 0; y < height; y++) {
+    auto *row = img.ptr<cv::Vec3b>(y);
+    for (int x = 0; x < width; x++) {
+      for (int c = 0; c < 3; c++) {
+        double wave = 60 * std::sin(x * 0.05 * (c + 1)) * std::cos(y * 0.03);
+        double edge = (x / 64 + y / 64) % 2 ? 40 : -40;
+        double v = 100 + wave + edge + rng.uniform(-15, 16);
+        row[x][c] = cv::saturate_cast<uchar>(v);
+      }
+    }
+  }
+  return img;
+}
+
+/**
+ * 对比 boxBlur 与 cv::GaussianBlur 的误差和耗时
+ * 用法: blur_accuracy [图像路径]
+ */
+int main(int argc, char **argv) {
+  cv::Mat img = argc > 1 ? cv::imread(argv[1], cv::IMREAD_COLOR)
+                         : syntheticImage(1024, 768);
+  if (img.empty()) {
+    std::fprintf(stderr, "无法读取图像: %s\n", argv[1]);
+    return 1;
+  }
+
+  std::printf("%6s %10s %8s %6s %8s %8s %10s %10s\n", "sigma", "radii",
+              "eff", "max", "mean", "psnr", "gauss_ms", "box_ms");
+  for (double sigma : {1.0, 1.5, 2.0, 3.0, 4.0, 5.0, 7.0, 9.0, 11.0}) {
+    cv::Mat exact, approx(img.size(), img.type());
+
+    int64 t0 = cv::getTickCount();
+    cv::GaussianBlur(img, exact, cv::Size(0, 0), sigma);
+    int64 t1 = cv::getTickCount();
+    BoxBlurPlan plan = boxBlurPlan(sigma);
+    boxBlur(img.data, img.step, approx.data, approx.step, img.cols, img.rows,
+            img.channels(), plan, 0, img.rows);
+    int64 t2 = cv::getTickCount();
+
+    cv::Mat diff;
+    cv::absdiff(exact, approx, diff);
+    double maxErr = 0;
+    cv::minMaxLoc(diff.reshape(1), nullptr, &maxErr);
+    double meanErr = cv::mean(diff.reshape(1))[0];
+    double variance = 0;
+    for (int r : plan.radius) {
+      variance += ((2 * r + 1) * (2 * r + 1) - 1) / 12.0;
+    }
+
+    double ms = 1000.0 / cv::getTickFrequency();
+    std::printf("%6.1f %4d/%2d/%2d %8.3f %6.0f %8.3f %8.2f %10.2f %10.2f\n",
+                sigma, plan.radius[0], plan.radius[1], plan.radius[2],
+                std::sqrt(variance), maxErr, meanErr,
+                cv::PSNR(exact, approx), (t1 - t0) * ms, (t2 - t1) * ms);
+  }
+  return 0;
+}
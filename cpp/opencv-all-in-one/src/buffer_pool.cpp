@@ -0,0 +1,99 @@
+#include "buffer_pool.h"
+#include "stats.h"
+
+#include <cstdlib>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+// 空闲缓冲区最多保留的总字节数，超出部分直接释放
+constexpr size_t kMaxRetainedBytes = size_t{256} << 20;
+constexpr size_t kMinClassBytes = size_t{4} << 10;
+
+/**
+ * 把请求尺寸向上取整到档位: 每个2的幂区间再四等分，浪费不超过25%
+ */
+size_t roundToClass(size_t size) {
+  if (size <= kMinClassBytes) {
+    return kMinClassBytes;
+  }
+  size_t top = kMinClassBytes;
+  while (top < size) {
+    top <<= 1;
+  }
+  size_t quarter = top / 8;
+  size_t bytes = top / 2;
+  while (bytes < size) {
+    bytes += quarter;
+  }
+  return bytes;
+}
+
+class BufferPool {
+public:
+  unsigned char *acquire(size_t size) {
+    size_t bytes = roundToClass(size);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = free_.find(bytes);
+      if (it != free_.end() && !it->second.empty()) {
+        unsigned char *buf = it->second.back();
+        it->second.pop_back();
+        retained_ -= bytes;
+        live_[buf] = bytes;
+        return buf;
+      }
+    }
+
+    auto buf = static_cast<unsigned char *>(std::malloc(bytes));
+    if (buf != nullptr) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      live_[buf] = bytes;
+    }
+    return buf;
+  }
+
+  void release(unsigned char *buf) {
+    if (buf == nullptr) {
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = live_.find(buf);
+      if (it != live_.end()) {
+        size_t bytes = it->second;
+        live_.erase(it);
+        if (retained_ + bytes <= kMaxRetainedBytes) {
+          free_[bytes].push_back(buf);
+          retained_ += bytes;
+          return;
+        }
+      }
+    }
+    std::free(buf);
+  }
+
+private:
+  std::mutex mutex_;
+  // 已借出的缓冲区及其档位尺寸
+  std::unordered_map<unsigned char *, size_t> live_;
+  // 按档位尺寸分组的空闲缓冲区
+  std::unordered_map<size_t, std::vector<unsigned char *>> free_;
+  size_t retained_ = 0;
+};
+
+BufferPool &pool() {
+  static BufferPool instance;
+  return instance;
+}
+
+} // namespace
+
+unsigned char *acquireBuffer(size_t size) {
+  MYLIB_TIMED(Stat::outputAlloc, size);
+  return pool().acquire(size);
+}
+
+void releaseBuffer(unsigned char *buf) { pool().release(buf); }
@@ -0,0 +1,18 @@
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include <cstddef>
+
+/**
+ * 从缓冲池获取至少 size 字节的缓冲区，失败返回 nullptr
+ * 缓冲区按尺寸档位复用，避免每帧重新 malloc 大块内存带来的缺页开销；
+ * 底层仍由 malloc 分配，因此调用方用 free 释放也是安全的(只是不会被复用)
+ */
+unsigned char *acquireBuffer(size_t size);
+
+/**
+ * 归还 acquireBuffer 得到的缓冲区；不是缓冲池分配的指针直接 free
+ */
+void releaseBuffer(unsigned char *buf);
+
+#endif // BUFFER_POOL_H
@@ -0,0 +1,63 @@
+// 按行拷贝内核，只能由 kernels_impl.h 在各版本的命名空间内包含
+
+#if defined(MYLIB_KERNEL_SSE2)
+
+/**
+ * 一行的非临时拷贝：先用普通拷贝把目标地址对齐到向量宽度，
+ * 中间整块用流式存储直接写内存，不读取目标缓存行，也不挤出缓存中的数据
+ */
+void streamRow(unsigned char const *src, unsigned char *dst, size_t n) {
+#if defined(MYLIB_KERNEL_AVX512)
+  constexpr size_t kWidth = 64;
+#elif defined(MYLIB_KERNEL_AVX2)
+  constexpr size_t kWidth = 32;
+#else
+  constexpr size_t kWidth = 16;
+#endif
+  size_t head = (kWidth - reinterpret_cast<uintptr_t>(dst) % kWidth) % kWidth;
+  if (head > n) {
+    head = n;
+  }
+  memcpy(dst, src, head);
+  size_t i = head;
+  for (; i + kWidth <= n; i += kWidth) {
+#if defined(MYLIB_KERNEL_AVX512)
+    _mm512_stream_si512(reinterpret_cast<__m512i *>(dst + i),
+                        _mm512_loadu_si512(src + i));
+#elif defined(MYLIB_KERNEL_AVX2)
+    _mm256_stream_si256(
+        reinterpret_cast<__m256i *>(dst + i),
+        _mm256_loadu_si256(reinterpret_cast<__m256i const *>(src + i)));
+#else
+    _mm_stream_si128(
+        reinterpret_cast<__m128i *>(dst + i),
+        _mm_loadu_si128(reinterpret_cast<__m128i const *>(src + i)));
+#endif
+  }
+  memcpy(dst + i, src + i, n - i);
+}
+
+#endif
+
+void copyRows(unsigned char const *src, size_t src_step, unsigned char *dst,
+              size_t dst_step, size_t row_bytes, int rows, bool stream) {
+#if defined(MYLIB_KERNEL_SSE2)
+  if (stream) {
+    for (int y = 0; y < rows; y++) {
+      streamRow(src + y * src_step, dst + y * dst_step, row_bytes);
+    }
+    // 流式存储是弱序的，返回前保证对其他线程可见
+    _mm_sfence();
+    return;
+  }
+#else
+  (void)stream;
+#endif
+  if (src_step == row_bytes && dst_step == row_bytes) {
+    memcpy(dst, src, row_bytes * rows);
+    return;
+  }
+  for (int y = 0; y < rows; y++) {
+    memcpy(dst + y * dst_step, src + y * src_step, row_bytes);
+  }
+}
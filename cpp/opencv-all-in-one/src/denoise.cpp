@@ -0,0 +1,101 @@
+#include "denoise.h"
+
+#include "arena.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// a ∈ [0, 1] 与 b ∈ [0, 255] 的定点小数位数，窗口和远小于 int32 的范围
+constexpr int kABits = 10;
+constexpr int kBBits = 4;
+
+/**
+ * 不归一化的窗口和，src 为 ROI 时从父图像读取 ROI 外的邻域行
+ */
+void windowSum(cv::Mat const &src, cv::Mat &dst, int radius) {
+  cv::boxFilter(src, dst, CV_32S, cv::Size(2 * radius + 1, 2 * radius + 1),
+                cv::Point(-1, -1), false, cv::BORDER_REFLECT_101);
+}
+
+} // namespace
+
+GuidedFilterPlan guidedFilterPlan(int value, float scale) {
+  value = std::clamp(value, 1, 100);
+  GuidedFilterPlan plan;
+  // 强度越大窗口越大、被当作噪声抹平的起伏越大(value 为100时标准差约30)
+  int radius = 2 + value / 25;
+  plan.radius = std::max(1, static_cast<int>(std::lround(radius * scale)));
+  float sigma = value * 0.3f;
+  plan.eps = sigma * sigma;
+  return plan;
+}
+
+int guidedFilterHalo(GuidedFilterPlan const &plan) { return 2 * plan.radius; }
+
+void guidedFilter(cv::Mat const &src, cv::Mat &dst,
+                  GuidedFilterPlan const &plan, int row_begin, int row_end) {
+  CV_Assert(src.type() == CV_8UC3);
+  int r = plan.radius;
+  int rows = src.rows;
+  int values = src.cols * 3;
+  int n = (2 * r + 1) * (2 * r + 1);
+
+  // a、b 需要条带上下各 r 行；它们的窗口和在 [lo, hi) 内读取，
+  // 而 [lo, hi) 的均值、方差又需要再向外 r 行的平方
+  int lo = std::max(0, row_begin - r);
+  int hi = std::min(rows, row_end + r);
+  int lo2 = std::max(0, lo - r);
+  int hi2 = std::min(rows, hi + r);
+
+  cv::Mat sq;
+  cv::Mat s1;
+  cv::Mat s2;
+  cv::Mat a;
+  cv::Mat b;
+  cv::Mat sa;
+  cv::Mat sb;
+  for (cv::Mat *m : {&sq, &s1, &s2, &a, &b, &sa, &sb}) {
+    m->allocator = arenaAllocator();
+  }
+
+  cv::Mat ext = src.rowRange(lo2, hi2);
+  cv::multiply(ext, ext, sq, 1.0, CV_16U);
+  windowSum(src.rowRange(lo, hi), s1, r);
+  windowSum(sq.rowRange(lo - lo2, hi - lo2), s2, r);
+
+  a.create(hi - lo, src.cols, CV_32SC3);
+  b.create(hi - lo, src.cols, CV_32SC3);
+  float invN = 1.0f / n;
+  float eps = plan.eps;
+  for (int y = 0; y < hi - lo; y++) {
+    int const *p1 = s1.ptr<int>(y);
+    int const *p2 = s2.ptr<int>(y);
+    int *pa = a.ptr<int>(y);
+    int *pb = b.ptr<int>(y);
+    for (int i = 0; i < values; i++) {
+      float mean = p1[i] * invN;
+      float var = std::max(p2[i] * invN - mean * mean, 0.0f);
+      float ai = var / (var + eps);
+      pa[i] = cvRound(ai * (1 << kABits));
+      pb[i] = cvRound((mean - ai * mean) * (1 << kBBits));
+    }
+  }
+  windowSum(a.rowRange(row_begin - lo, row_end - lo), sa, r);
+  windowSum(b.rowRange(row_begin - lo, row_end - lo), sb, r);
+
+  // q = (Σa·I + Σb) / n
+  float aScale = invN / (1 << kABits);
+  float bScale = invN / (1 << kBBits);
+  for (int y = row_begin; y < row_end; y++) {
+    unsigned char const *in = src.ptr(y);
+    unsigned char *out = dst.ptr(y);
+    int const *qa = sa.ptr<int>(y - row_begin);
+    int const *qb = sb.ptr<int>(y - row_begin);
+    for (int i = 0; i < values; i++) {
+      float q = static_cast<float>(qa[i]) * in[i] * aScale + qb[i] * bScale;
+      out[i] = cv::saturate_cast<unsigned char>(q);
+    }
+  }
+}
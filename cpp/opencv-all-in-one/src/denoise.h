@@ -0,0 +1,41 @@
+#ifndef DENOISE_H
+#define DENOISE_H
+
+#include <opencv2/opencv.hpp>
+
+/**
+ * 自引导滤波(guided filter，引导图为输入自身)的参数
+ */
+struct GuidedFilterPlan {
+  int radius; // 窗口为 (2*radius+1)²
+  float eps;  // 正则项，单位为8位灰度的平方；方差远小于它的区域被抹平
+};
+
+/**
+ * 由降噪强度选取参数
+ * @param value 强度 1-100
+ * @param scale 图像相对原图的缩放比例，半径随之缩小，用于预览
+ */
+GuidedFilterPlan guidedFilterPlan(int value, float scale = 1.0f);
+
+/**
+ * 按条带处理时在每个方向上需要的邻域行数(两次窗口均值)
+ */
+int guidedFilterHalo(GuidedFilterPlan const &plan);
+
+/**
+ * 对三通道8位图像逐通道做自引导滤波：q = mean(a)·I + mean(b)，
+ * a = var/(var+eps)，b = (1-a)·mean；边缘处方差大、a 接近1而保留原值，
+ * 平坦处 a 接近0而取局部均值
+ * 窗口均值用 cv::boxFilter 的整数窗口和计算，耗时与半径无关；a、b 量化为
+ * 定点整数后再求窗口和，条带边界处的计算与整图完全相同，因此按条带并行的
+ * 结果与整图处理逐位一致。边界按 BORDER_REFLECT_101 外推
+ * 只输出 [row_begin, row_end) 行，读取 src 中条带上下各 guidedFilterHalo 行，
+ * 临时图像从调用线程的 arena 分配
+ * @param src 8位三通道
+ * @param dst 已分配，尺寸类型与 src 相同，不能与 src 重叠
+ */
+void guidedFilter(cv::Mat const &src, cv::Mat &dst,
+                  GuidedFilterPlan const &plan, int row_begin, int row_end);
+
+#endif // DENOISE_H
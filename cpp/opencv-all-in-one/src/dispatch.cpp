@@ -0,0 +1,150 @@
+#include "dispatch.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(MYLIB_DISPATCH_X86)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// 各级别的内核表，定义见 kernels_impl.h
+namespace kernels_baseline {
+extern KernelTable const table;
+}
+#if defined(MYLIB_DISPATCH_X86)
+namespace kernels_sse42 {
+extern KernelTable const table;
+}
+namespace kernels_avx2 {
+extern KernelTable const table;
+}
+namespace kernels_avx512 {
+extern KernelTable const table;
+}
+#endif
+
+namespace {
+
+#if defined(MYLIB_DISPATCH_X86)
+
+struct cpuidRegs {
+  unsigned eax, ebx, ecx, edx;
+};
+
+cpuidRegs cpuid(unsigned leaf, unsigned subleaf) {
+  cpuidRegs r;
+#if defined(_MSC_VER)
+  int v[4];
+  __cpuidex(v, static_cast<int>(leaf), static_cast<int>(subleaf));
+  r = {static_cast<unsigned>(v[0]), static_cast<unsigned>(v[1]),
+       static_cast<unsigned>(v[2]), static_cast<unsigned>(v[3])};
+#else
+  __cpuid_count(leaf, subleaf, r.eax, r.ebx, r.ecx, r.edx);
+#endif
+  return r;
+}
+
+/**
+ * XCR0：操作系统在上下文切换时保存了哪些寄存器状态
+ */
+unsigned long long xcr0() {
+#if defined(_MSC_VER)
+  return _xgetbv(0);
+#else
+  unsigned eax, edx;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return static_cast<unsigned long long>(edx) << 32 | eax;
+#endif
+}
+
+inline bool bit(unsigned reg, int i) { return (reg >> i & 1) != 0; }
+
+#endif
+
+KernelTable const &tableFor(CpuLevel level) {
+  switch (level) {
+#if defined(MYLIB_DISPATCH_X86)
+  case CpuLevel::avx512:
+    return kernels_avx512::table;
+  case CpuLevel::avx2:
+    return kernels_avx2::table;
+  case CpuLevel::sse42:
+    return kernels_sse42::table;
+#endif
+  default:
+    return kernels_baseline::table;
+  }
+}
+
+/**
+ * 解析 MYLIB_CPU_LEVEL，接受级别名称或数字
+ */
+bool parseLevel(char const *text, CpuLevel &level) {
+  static char const *const names[] = {"baseline", "sse42", "avx2", "avx512"};
+  for (int i = 0; i < 4; i++) {
+    char digit[2] = {static_cast<char>('0' + i), '\0'};
+    if (std::strcmp(text, names[i]) == 0 || std::strcmp(text, digit) == 0) {
+      level = static_cast<CpuLevel>(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+KernelTable const &selectKernels() {
+  CpuLevel level = detectCpuLevel();
+  char const *forced = std::getenv("MYLIB_CPU_LEVEL");
+  if (forced != nullptr && *forced != '\0') {
+    CpuLevel want;
+    if (!parseLevel(forced, want)) {
+      std::fprintf(stderr, "mylib: 忽略无效的 MYLIB_CPU_LEVEL=%s\n", forced);
+    } else if (want > level) {
+      std::fprintf(stderr, "mylib: CPU 不支持 MYLIB_CPU_LEVEL=%s，使用 %s\n",
+                   forced, tableFor(level).name);
+    } else {
+      level = want;
+    }
+  }
+  return tableFor(level);
+}
+
+// 库加载时(静态初始化阶段)完成选择；kernels() 本身也可以在此之前被调用
+[[maybe_unused]] KernelTable const &gLoadTimeSelection = kernels();
+
+} // namespace
+
+CpuLevel detectCpuLevel() {
+#if defined(MYLIB_DISPATCH_X86)
+  unsigned maxLeaf = cpuid(0, 0).eax;
+  cpuidRegs r1 = cpuid(1, 0);
+  // SSSE3、SSE4.1、SSE4.2
+  if (!bit(r1.ecx, 9) || !bit(r1.ecx, 19) || !bit(r1.ecx, 20)) {
+    return CpuLevel::baseline;
+  }
+  // AVX 指令要求 CPU 支持 OSXSAVE 且操作系统保存 XMM/YMM 状态
+  if (maxLeaf < 7 || !bit(r1.ecx, 27) || !bit(r1.ecx, 28)) {
+    return CpuLevel::sse42;
+  }
+  unsigned long long xcr = xcr0();
+  cpuidRegs r7 = cpuid(7, 0);
+  if ((xcr & 0x6) != 0x6 || !bit(r7.ebx, 5)) {
+    return CpuLevel::sse42;
+  }
+  // AVX-512 F、DQ、BW、VL，另需操作系统保存 opmask 与 ZMM 状态
+  bool avx512 = bit(r7.ebx, 16) && bit(r7.ebx, 17) && bit(r7.ebx, 30) &&
+                bit(r7.ebx, 31) && (xcr & 0xe6) == 0xe6;
+  return avx512 ? CpuLevel::avx512 : CpuLevel::avx2;
+#else
+  return CpuLevel::baseline;
+#endif
+}
+
+KernelTable const &kernels() {
+  static KernelTable const &selected = selectKernels();
+  return selected;
+}
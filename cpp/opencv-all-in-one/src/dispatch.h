@@ -0,0 +1,81 @@
+#ifndef DISPATCH_H
+#define DISPATCH_H
+
+#include <cstddef>
+#include <cstdint>
+
+struct BoxBlurPlan;
+struct LutTable;
+enum class SaturationMode;
+
+/**
+ * 像素内核的指令集级别，数值越大要求越高
+ */
+enum class CpuLevel {
+  baseline = 0, // x86-64 为 SSE2，其他架构为纯标量
+  sse42 = 1,
+  avx2 = 2,
+  avx512 = 3, // AVX-512 F/BW/VL/DQ
+};
+
+/**
+ * 同一组像素内核针对某个指令集级别编译的版本，
+ * 每个版本由一个 kernels_*.cpp 编译单元提供，函数的约定见各自的公共声明
+ */
+struct KernelTable {
+  CpuLevel level;
+  char const *name;
+
+  // 见 lut.h 中的 applyLut
+  void (*applyLut)(unsigned char const *src, unsigned char *dst, size_t n,
+                   LutTable const &lut);
+
+  // 见 saturation.h 中的 saturateRow
+  void (*saturateRow)(unsigned char const *src, unsigned char *dst,
+                      int pixels, float factor, SaturationMode mode);
+
+  // 见 fast_blur.h 中的 boxBlur
+  void (*boxBlur)(unsigned char const *src, size_t src_step,
+                  unsigned char *dst, size_t dst_step, int width, int height,
+                  int channels, BoxBlurPlan const &plan, int row_begin,
+                  int row_end);
+
+  // 见 fixed_sharpen.h 中的 sharpen3x3，强度为 Q10 定点
+  void (*sharpen3x3)(unsigned char const *src, size_t src_step,
+                     unsigned char *dst, size_t dst_step, int width,
+                     int height, int channels, int strength_q10,
+                     int row_begin, int row_end);
+
+  /**
+   * 按行拷贝，src 与 dst 不能重叠
+   * @param stream 为真时用非临时存储写 dst，不占用缓存；适合拷贝量超过
+   *        末级缓存、且结果不会马上被读取的情况
+   */
+  void (*copyRows)(unsigned char const *src, size_t src_step,
+                   unsigned char *dst, size_t dst_step, size_t row_bytes,
+                   int rows, bool stream);
+
+  // 见 resample.h 中的 resampleRow，系数为 ResampleAxis 的 start 与 weights
+  void (*resampleRow)(unsigned char const *src, unsigned char *dst,
+                      int src_width, int dst_width, int taps,
+                      int const *start, int16_t const *weights);
+
+  // 见 resample.h 中的 resampleColumns
+  void (*resampleColumns)(unsigned char const *const *rows,
+                          int16_t const *weights, int taps,
+                          unsigned char *dst, size_t n);
+};
+
+/**
+ * CPU 与操作系统共同支持的最高级别
+ */
+CpuLevel detectCpuLevel();
+
+/**
+ * 库加载时选定的内核：默认为 detectCpuLevel 的级别，
+ * 环境变量 MYLIB_CPU_LEVEL (baseline/sse42/avx2/avx512 或 0-3) 可以指定
+ * 更低的级别用于测试，超出 CPU 支持的级别时忽略并输出警告
+ */
+KernelTable const &kernels();
+
+#endif // DISPATCH_H
@@ -0,0 +1,36 @@
+#include "fast_blur.h"
+
+#include "dispatch.h"
+
+#include <cmath>
+
+BoxBlurPlan boxBlurPlan(double sigma) {
+  constexpr int n = 3;
+  double ideal = std::sqrt(12.0 * sigma * sigma / n + 1.0);
+  int wl = static_cast<int>(std::floor(ideal));
+  if (wl % 2 == 0) {
+    wl--;
+  }
+  int wu = wl + 2;
+  double mIdeal =
+      (12.0 * sigma * sigma - n * wl * wl - 4.0 * n * wl - 3.0 * n) /
+      (-4.0 * wl - 4.0);
+  int m = static_cast<int>(std::lround(mIdeal));
+
+  BoxBlurPlan plan;
+  for (int i = 0; i < n; i++) {
+    plan.radius[i] = ((i < m ? wl : wu) - 1) / 2;
+  }
+  return plan;
+}
+
+int boxBlurHalo(BoxBlurPlan const &plan) {
+  return plan.radius[0] + plan.radius[1] + plan.radius[2];
+}
+
+void boxBlur(unsigned char const *src, size_t src_step, unsigned char *dst,
+             size_t dst_step, int width, int height, int channels,
+             BoxBlurPlan const &plan, int row_begin, int row_end) {
+  kernels().boxBlur(src, src_step, dst, dst_step, width, height, channels,
+                    plan, row_begin, row_end);
+}
@@ -0,0 +1,34 @@
+#ifndef FAST_BLUR_H
+#define FAST_BLUR_H
+
+#include <cstddef>
+
+/**
+ * 3次盒式滤波的半径，叠加后近似给定 sigma 的高斯核
+ */
+struct BoxBlurPlan {
+  int radius[3];
+};
+
+/**
+ * 按 Kovesi 的方法选取3个盒式滤波宽度，使叠加后的方差最接近 sigma^2
+ */
+BoxBlurPlan boxBlurPlan(double sigma);
+
+/**
+ * 盒式滤波叠加后在每个方向上需要的邻域行数
+ */
+int boxBlurHalo(BoxBlurPlan const &plan);
+
+/**
+ * 用横竖各3次盒式滤波近似高斯模糊，每像素耗时与 sigma 无关
+ * 边界按 BORDER_REFLECT_101 外推，与 cv::GaussianBlur 默认一致；
+ * 只输出 [row_begin, row_end) 行，但会读取整幅 src，便于按条带并行
+ * @param src 8位交错像素，每像素 channels 个字节
+ * @param dst 输出，不能与 src 重叠
+ */
+void boxBlur(unsigned char const *src, size_t src_step, unsigned char *dst,
+             size_t dst_step, int width, int height, int channels,
+             BoxBlurPlan const &plan, int row_begin, int row_end);
+
+#endif // FAST_BLUR_H
@@ -0,0 +1,441 @@
+// 盒式滤波内核，只能由 kernels_impl.h 在各版本的命名空间内包含
+
+// 中间结果以 u16 保存，带4位小数
+constexpr int kFracBits = 4;
+constexpr float kFracScale = 1 << kFracBits;
+// 竖直方向每次处理的行数和列数，使中间缓冲留在L2中
+constexpr int kChunkRows = 256;
+constexpr int kTileCols = 256;
+
+// 8个 u16 为一组，累加器为8个 u32；SIMD与标量实现的取整方式一致(就近取偶)
+#if defined(MYLIB_KERNEL_SSE2)
+
+using U16x8 = __m128i;
+
+inline U16x8 loadU8x8(unsigned char const *p) {
+  return _mm_unpacklo_epi8(
+      _mm_loadl_epi64(reinterpret_cast<__m128i const *>(p)),
+      _mm_setzero_si128());
+}
+
+inline U16x8 loadU16x8(uint16_t const *p) {
+  return _mm_loadu_si128(reinterpret_cast<__m128i const *>(p));
+}
+
+inline void storeU16x8(uint16_t *p, U16x8 v) {
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v);
+}
+
+#if defined(MYLIB_KERNEL_AVX2)
+
+struct Acc {
+  __m256i v;
+};
+
+inline Acc accZero() { return {_mm256_setzero_si256()}; }
+
+inline Acc accAdd(Acc a, U16x8 x) {
+  return {_mm256_add_epi32(a.v, _mm256_cvtepu16_epi32(x))};
+}
+
+inline Acc accSub(Acc a, U16x8 x) {
+  return {_mm256_sub_epi32(a.v, _mm256_cvtepu16_epi32(x))};
+}
+
+// 结果不超过 4080，可以用有符号饱和收窄
+inline U16x8 accScale(Acc a, float m) {
+  __m256i r = _mm256_cvtps_epi32(
+      _mm256_mul_ps(_mm256_cvtepi32_ps(a.v), _mm256_set1_ps(m)));
+  return _mm_packs_epi32(_mm256_castsi256_si128(r),
+                         _mm256_extracti128_si256(r, 1));
+}
+
+#else
+
+struct Acc {
+  __m128i lo, hi;
+};
+
+inline Acc accZero() { return {_mm_setzero_si128(), _mm_setzero_si128()}; }
+
+inline Acc accAdd(Acc a, U16x8 x) {
+  __m128i z = _mm_setzero_si128();
+  return {_mm_add_epi32(a.lo, _mm_unpacklo_epi16(x, z)),
+          _mm_add_epi32(a.hi, _mm_unpackhi_epi16(x, z))};
+}
+
+inline Acc accSub(Acc a, U16x8 x) {
+  __m128i z = _mm_setzero_si128();
+  return {_mm_sub_epi32(a.lo, _mm_unpacklo_epi16(x, z)),
+          _mm_sub_epi32(a.hi, _mm_unpackhi_epi16(x, z))};
+}
+
+inline U16x8 accScale(Acc a, float m) {
+  __m128 f = _mm_set1_ps(m);
+  return _mm_packs_epi32(
+      _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(a.lo), f)),
+      _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(a.hi), f)));
+}
+
+#endif
+
+/**
+ * 8x8 的 u16 矩阵转置，r[i] 为第 i 行
+ */
+inline void transpose8x8(U16x8 *r) {
+  __m128i a0 = _mm_unpacklo_epi16(r[0], r[1]);
+  __m128i a1 = _mm_unpackhi_epi16(r[0], r[1]);
+  __m128i a2 = _mm_unpacklo_epi16(r[2], r[3]);
+  __m128i a3 = _mm_unpackhi_epi16(r[2], r[3]);
+  __m128i a4 = _mm_unpacklo_epi16(r[4], r[5]);
+  __m128i a5 = _mm_unpackhi_epi16(r[4], r[5]);
+  __m128i a6 = _mm_unpacklo_epi16(r[6], r[7]);
+  __m128i a7 = _mm_unpackhi_epi16(r[6], r[7]);
+  __m128i b0 = _mm_unpacklo_epi32(a0, a2);
+  __m128i b1 = _mm_unpackhi_epi32(a0, a2);
+  __m128i b2 = _mm_unpacklo_epi32(a1, a3);
+  __m128i b3 = _mm_unpackhi_epi32(a1, a3);
+  __m128i b4 = _mm_unpacklo_epi32(a4, a6);
+  __m128i b5 = _mm_unpackhi_epi32(a4, a6);
+  __m128i b6 = _mm_unpacklo_epi32(a5, a7);
+  __m128i b7 = _mm_unpackhi_epi32(a5, a7);
+  r[0] = _mm_unpacklo_epi64(b0, b4);
+  r[1] = _mm_unpackhi_epi64(b0, b4);
+  r[2] = _mm_unpacklo_epi64(b1, b5);
+  r[3] = _mm_unpackhi_epi64(b1, b5);
+  r[4] = _mm_unpacklo_epi64(b2, b6);
+  r[5] = _mm_unpackhi_epi64(b2, b6);
+  r[6] = _mm_unpacklo_epi64(b3, b7);
+  r[7] = _mm_unpackhi_epi64(b3, b7);
+}
+
+inline void storeU8x8(unsigned char *p, U16x8 v) {
+  _mm_storel_epi64(reinterpret_cast<__m128i *>(p), _mm_packus_epi16(v, v));
+}
+
+#else
+
+struct U16x8 {
+  uint16_t v[8];
+};
+
+inline U16x8 loadU8x8(unsigned char const *p) {
+  U16x8 r;
+  for (int i = 0; i < 8; i++) {
+    r.v[i] = p[i];
+  }
+  return r;
+}
+
+inline U16x8 loadU16x8(uint16_t const *p) {
+  U16x8 r;
+  memcpy(r.v, p, sizeof(r.v));
+  return r;
+}
+
+inline void storeU16x8(uint16_t *p, U16x8 v) { memcpy(p, v.v, sizeof(v.v)); }
+
+struct Acc {
+  uint32_t v[8];
+};
+
+inline Acc accZero() { return {}; }
+
+inline Acc accAdd(Acc a, U16x8 x) {
+  for (int i = 0; i < 8; i++) {
+    a.v[i] += x.v[i];
+  }
+  return a;
+}
+
+inline Acc accSub(Acc a, U16x8 x) {
+  for (int i = 0; i < 8; i++) {
+    a.v[i] -= x.v[i];
+  }
+  return a;
+}
+
+inline U16x8 accScale(Acc a, float m) {
+  U16x8 r;
+  for (int i = 0; i < 8; i++) {
+    r.v[i] = static_cast<uint16_t>(lrintf(static_cast<float>(a.v[i]) * m));
+  }
+  return r;
+}
+
+inline void transpose8x8(U16x8 *r) {
+  for (int i = 0; i < 8; i++) {
+    for (int j = i + 1; j < 8; j++) {
+      uint16_t t = r[i].v[j];
+      r[i].v[j] = r[j].v[i];
+      r[j].v[i] = t;
+    }
+  }
+}
+
+inline void storeU8x8(unsigned char *p, U16x8 v) {
+  for (int i = 0; i < 8; i++) {
+    p[i] = static_cast<unsigned char>(v.v[i] < 255 ? v.v[i] : 255);
+  }
+}
+
+#endif
+
+inline uint16_t scaleScalar(uint32_t acc, float m) {
+  return static_cast<uint16_t>(lrintf(static_cast<float>(acc) * m));
+}
+
+/**
+ * 竖直方向一次盒式滤波，处理 cols 列，输出 [y0, y1) 行
+ * row(y) 返回第 y 行(已做边界映射)的起始指针
+ * 输出 = round(窗口和 * m)
+ */
+template <typename T, typename Row>
+void verticalPass(Row row, int y0, int y1, int radius, int cols, float m,
+                  uint16_t *out, size_t out_stride) {
+  int groups = cols / 8;
+  int rest = cols - groups * 8;
+  Acc acc[kTileCols / 8];
+  uint32_t tail[8];
+  for (int g = 0; g < groups; g++) {
+    acc[g] = accZero();
+  }
+  for (int k = 0; k < rest; k++) {
+    tail[k] = 0;
+  }
+
+  auto load = [](T const *p) {
+    if constexpr (sizeof(T) == 1) {
+      return loadU8x8(p);
+    } else {
+      return loadU16x8(p);
+    }
+  };
+
+  for (int t = -radius; t <= radius; t++) {
+    T const *p = row(y0 + t);
+    for (int g = 0; g < groups; g++) {
+      acc[g] = accAdd(acc[g], load(p + g * 8));
+    }
+    for (int k = 0; k < rest; k++) {
+      tail[k] += p[groups * 8 + k];
+    }
+  }
+
+  // 先滑窗再输出，只读取 [y0 - radius, y1 - 1 + radius] 这些行
+  for (int y = y0; y < y1; y++) {
+    uint16_t *o = out + (y - y0) * out_stride;
+    if (y > y0) {
+      T const *add = row(y + radius);
+      T const *sub = row(y - radius - 1);
+      for (int g = 0; g < groups; g++) {
+        acc[g] = accSub(accAdd(acc[g], load(add + g * 8)), load(sub + g * 8));
+      }
+      for (int k = 0; k < rest; k++) {
+        int c = groups * 8 + k;
+        tail[k] += add[c];
+        tail[k] -= sub[c];
+      }
+    }
+    for (int g = 0; g < groups; g++) {
+      storeU16x8(o + g * 8, accScale(acc[g], m));
+    }
+    for (int k = 0; k < rest; k++) {
+      o[groups * 8 + k] = scaleScalar(tail[k], m);
+    }
+  }
+}
+
+/**
+ * 水平方向的3次盒式滤波，一次处理8行
+ * 把8行转置成 “每列一个向量” 后沿行方向滑窗，8行在SIMD通道里同时计算；
+ * 缓冲区中第 i 列的8个值连续存放在 [i * 8, i * 8 + 8)
+ */
+class HorizontalBlur {
+public:
+  HorizontalBlur(int width, int channels, BoxBlurPlan const &plan)
+      : width_(width), channels_(channels), plan_(plan),
+        pad_((maxOf(maxOf(plan.radius[0], plan.radius[1]), plan.radius[2]) +
+              1) *
+             channels),
+        n_(width * channels), bufA_(static_cast<size_t>(n_ + 2 * pad_) * 8),
+        bufB_(static_cast<size_t>(n_ + 2 * pad_) * 8), a_(bufA_.data()),
+        b_(bufB_.data()) {}
+
+  /**
+   * rows[i] 为第 i 行的 u16 数据(带 kFracBits 位小数)，out[i] 为对应的8位输出，
+   * 为空时丢弃该行
+   */
+  void run(uint16_t const *const *rows, unsigned char *const *out) {
+    load(rows);
+    for (int k = 0; k < 3; k++) {
+      int w = 2 * plan_.radius[k] + 1;
+      float m = k < 2 ? 1.0f / w : 1.0f / (w * kFracScale);
+      pass(plan_.radius[k], m);
+      uint16_t *t = a_;
+      a_ = b_;
+      b_ = t;
+      if (k < 2) {
+        fillPadding();
+      }
+    }
+    store(out);
+  }
+
+private:
+  uint16_t *column(uint16_t *buf, int i) {
+    return buf + static_cast<size_t>(i + pad_) * 8;
+  }
+
+  void load(uint16_t const *const *rows) {
+    int i = 0;
+    for (; i + 8 <= n_; i += 8) {
+      U16x8 block[8];
+      for (int j = 0; j < 8; j++) {
+        block[j] = loadU16x8(rows[j] + i);
+      }
+      transpose8x8(block);
+      for (int k = 0; k < 8; k++) {
+        storeU16x8(column(a_, i + k), block[k]);
+      }
+    }
+    for (; i < n_; i++) {
+      uint16_t *col = column(a_, i);
+      for (int j = 0; j < 8; j++) {
+        col[j] = rows[j][i];
+      }
+    }
+    fillPadding();
+  }
+
+  void fillPadding() {
+    for (int i = -pad_; i < 0; i++) {
+      int c = ((i % channels_) + channels_) % channels_;
+      int x = (i - c) / channels_;
+      storeU16x8(column(a_, i),
+                 loadU16x8(column(a_, reflect101(x, width_) * channels_ + c)));
+    }
+    for (int i = n_; i < n_ + pad_; i++) {
+      int c = i % channels_;
+      int x = reflect101(i / channels_, width_);
+      storeU16x8(column(a_, i), loadU16x8(column(a_, x * channels_ + c)));
+    }
+  }
+
+  void pass(int radius, float m) {
+    uint16_t const *a = column(a_, 0);
+    uint16_t *b = column(b_, 0);
+    int const cn = channels_;
+    ptrdiff_t const ahead = static_cast<ptrdiff_t>(radius + 1) * cn * 8;
+    ptrdiff_t const behind = static_cast<ptrdiff_t>(radius) * cn * 8;
+    for (int c = 0; c < cn; c++) {
+      Acc acc = accZero();
+      for (int t = -radius; t <= radius; t++) {
+        acc = accAdd(acc, loadU16x8(a + (c + t * cn) * 8));
+      }
+      for (int i = c; i < n_; i += cn) {
+        uint16_t const *p = a + static_cast<ptrdiff_t>(i) * 8;
+        storeU16x8(b + static_cast<ptrdiff_t>(i) * 8, accScale(acc, m));
+        acc = accSub(accAdd(acc, loadU16x8(p + ahead)), loadU16x8(p - behind));
+      }
+    }
+  }
+
+  void store(unsigned char *const *out) {
+    int i = 0;
+    for (; i + 8 <= n_; i += 8) {
+      U16x8 block[8];
+      for (int k = 0; k < 8; k++) {
+        block[k] = loadU16x8(column(a_, i + k));
+      }
+      transpose8x8(block);
+      for (int j = 0; j < 8; j++) {
+        if (out[j] != nullptr) {
+          storeU8x8(out[j] + i, block[j]);
+        }
+      }
+    }
+    for (; i < n_; i++) {
+      uint16_t const *col = column(a_, i);
+      for (int j = 0; j < 8; j++) {
+        if (out[j] != nullptr) {
+          out[j][i] = static_cast<unsigned char>(col[j]);
+        }
+      }
+    }
+  }
+
+  int width_;
+  int channels_;
+  BoxBlurPlan plan_;
+  int pad_;
+  int n_;
+  scratch<uint16_t> bufA_;
+  scratch<uint16_t> bufB_;
+  uint16_t *a_;
+  uint16_t *b_;
+};
+
+void boxBlur(unsigned char const *src, size_t src_step, unsigned char *dst,
+             size_t dst_step, int width, int height, int channels,
+             BoxBlurPlan const &plan, int row_begin, int row_end) {
+  int const n = width * channels;
+  int const r1 = plan.radius[0];
+  int const r2 = plan.radius[1];
+  int const r3 = plan.radius[2];
+  float const m1 = kFracScale / (2 * r1 + 1);
+  float const m2 = 1.0f / (2 * r2 + 1);
+  float const m3 = 1.0f / (2 * r3 + 1);
+
+  // 按一个块的最大行数和一个列块的最大宽度分配
+  int const chunk = minOf(kChunkRows, row_end - row_begin);
+  int const tile = minOf(kTileCols, n);
+  scratch<uint16_t> p1(static_cast<size_t>(
+                           minOf(height, chunk + 2 * (r2 + r3))) *
+                       tile);
+  scratch<uint16_t> p2(static_cast<size_t>(minOf(height, chunk + 2 * r3)) *
+                       tile);
+  scratch<uint16_t> vert(static_cast<size_t>(chunk) * n);
+  HorizontalBlur horizontal(width, channels, plan);
+
+  for (int c0 = row_begin; c0 < row_end; c0 += kChunkRows) {
+    int c1 = minOf(c0 + kChunkRows, row_end);
+    // 前两次竖直滤波要多算出后续各次半径之和的 halo 行；
+    // 越界的行经过 reflect101 映射后都落在这些范围之内
+    int a1 = maxOf(0, c0 - r2 - r3);
+    int b1 = minOf(height, c1 + r2 + r3);
+    int a2 = maxOf(0, c0 - r3);
+    int b2 = minOf(height, c1 + r3);
+
+    for (int t0 = 0; t0 < n; t0 += kTileCols) {
+      int tw = minOf(kTileCols, n - t0);
+
+      verticalPass<unsigned char>(
+          [&](int y) { return src + reflect101(y, height) * src_step + t0; },
+          a1, b1, r1, tw, m1, p1.data(), tw);
+      verticalPass<uint16_t>(
+          [&](int y) {
+            size_t i = reflect101(y, height) - a1;
+            return p1.data() + i * tw;
+          },
+          a2, b2, r2, tw, m2, p2.data(), tw);
+      verticalPass<uint16_t>(
+          [&](int y) {
+            size_t i = reflect101(y, height) - a2;
+            return p2.data() + i * tw;
+          },
+          c0, c1, r3, tw, m3, vert.data() + t0, n);
+    }
+
+    for (int y = c0; y < c1; y += 8) {
+      uint16_t const *rows[8];
+      unsigned char *out[8];
+      for (int j = 0; j < 8; j++) {
+        int yy = minOf(y + j, c1 - 1);
+        rows[j] = vert.data() + static_cast<size_t>(yy - c0) * n;
+        out[j] = y + j < c1 ? dst + (y + j) * dst_step : nullptr;
+      }
+      horizontal.run(rows, out);
+    }
+  }
+}
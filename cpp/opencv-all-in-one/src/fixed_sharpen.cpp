@@ -0,0 +1,13 @@
+#include "fixed_sharpen.h"
+
+#include "dispatch.h"
+
+#include <cmath>
+
+void sharpen3x3(unsigned char const *src, size_t src_step, unsigned char *dst,
+                size_t dst_step, int width, int height, int channels,
+                float strength, int row_begin, int row_end) {
+  int q = static_cast<int>(std::lrintf(strength * (1 << kSharpenFracBits)));
+  kernels().sharpen3x3(src, src_step, dst, dst_step, width, height, channels,
+                       q, row_begin, row_end);
+}
@@ -0,0 +1,26 @@
+#ifndef FIXED_SHARPEN_H
+#define FIXED_SHARPEN_H
+
+#include <cstddef>
+
+/**
+ * 锐化强度定点表示的小数位数
+ */
+constexpr int kSharpenFracBits = 10;
+
+/**
+ * 十字形3x3锐化: out = c + s * (4c - 上 - 下 - 左 - 右)
+ * 与中心 1+4s、四邻 -s 的卷积核等价，但每个字节只需一次乘法；
+ * s 量化为 Q10 定点，拉普拉斯项与乘积在 int16 通道中计算，饱和收窄到8位，
+ * 与浮点 filter2D 的结果相差不超过1
+ * 边界按 BORDER_REFLECT_101 外推；只输出 [row_begin, row_end) 行，但会读取
+ * 整幅 src，便于按条带并行
+ * @param src 8位交错像素，每像素 channels 个字节
+ * @param dst 输出，不能与 src 重叠
+ * @param strength 锐化强度 s，范围 [0, 2]
+ */
+void sharpen3x3(unsigned char const *src, size_t src_step, unsigned char *dst,
+                size_t dst_step, int width, int height, int channels,
+                float strength, int row_begin, int row_end);
+
+#endif // FIXED_SHARPEN_H
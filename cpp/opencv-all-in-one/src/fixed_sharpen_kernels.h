@@ -0,0 +1,135 @@
+// 定点锐化内核，只能由 kernels_impl.h 在各版本的命名空间内包含
+
+// 拉普拉斯项 |lap| <= 1020，左移后不超过 int16 范围，
+// 与 Q10 强度相乘再经 mulhrs 的 >> 15 得到按四舍五入取整的 s * lap
+constexpr int kLapShift = 15 - kSharpenFracBits;
+
+/**
+ * 一个字节的标量计算，与 SIMD 的 mulhrs 逐位一致
+ * @param sum4 上下左右四个邻居之和
+ */
+inline unsigned char sharpenScalar(int c, int sum4, int q) {
+  int lap = 4 * c - sum4;
+  int v = c + (((lap << kLapShift) * q + 0x4000) >> 15);
+  return static_cast<unsigned char>(minOf(maxOf(v, 0), 255));
+}
+
+/**
+ * 每行首尾各一个像素的左右邻居按 reflect101 取
+ */
+inline void sharpenEdge(unsigned char const *up, unsigned char const *mid,
+                        unsigned char const *down, unsigned char *out, int n,
+                        int cn, int q, int i) {
+  int single = n == cn;
+  int left = i >= cn ? i - cn : (single ? i : i + cn);
+  int right = i + cn < n ? i + cn : (single ? i : i - cn);
+  out[i] = sharpenScalar(mid[i], up[i] + down[i] + mid[left] + mid[right], q);
+}
+
+#if defined(MYLIB_KERNEL_SSE2)
+
+/**
+ * (a * b + 0x4000) >> 15，SSE2 没有 pmulhrsw 时由32位乘积的高低两半拼出
+ */
+inline __m128i mulhrs(__m128i a, __m128i b) {
+#if defined(MYLIB_KERNEL_SSE41)
+  return _mm_mulhrs_epi16(a, b);
+#else
+  __m128i t = _mm_or_si128(_mm_slli_epi16(_mm_mulhi_epi16(a, b), 2),
+                           _mm_srli_epi16(_mm_mullo_epi16(a, b), 14));
+  return _mm_srai_epi16(_mm_add_epi16(t, _mm_set1_epi16(1)), 1);
+#endif
+}
+
+#endif
+
+void sharpenRow(unsigned char const *up, unsigned char const *mid,
+                unsigned char const *down, unsigned char *out, int n, int cn,
+                int q) {
+  int i = 0;
+  for (; i < cn; i++) {
+    sharpenEdge(up, mid, down, out, n, cn, q, i);
+  }
+  int const end = n - cn;
+
+#if defined(MYLIB_KERNEL_AVX512)
+  __m512i const qv = _mm512_set1_epi16(static_cast<short>(q));
+  __m512i const zero = _mm512_setzero_si512();
+  auto load = [](unsigned char const *p) {
+    return _mm512_cvtepu8_epi16(
+        _mm256_loadu_si256(reinterpret_cast<__m256i const *>(p)));
+  };
+  for (; i + 32 <= end; i += 32) {
+    __m512i c = load(mid + i);
+    __m512i lap = _mm512_sub_epi16(
+        _mm512_slli_epi16(c, 2),
+        _mm512_add_epi16(_mm512_add_epi16(load(up + i), load(down + i)),
+                         _mm512_add_epi16(load(mid + i - cn),
+                                          load(mid + i + cn))));
+    __m512i v = _mm512_add_epi16(
+        c, _mm512_mulhrs_epi16(_mm512_slli_epi16(lap, kLapShift), qv));
+    // 先截掉负数，再按无符号饱和收窄；带掩码的版本避免 GCC 12 的误报警告
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i *>(out + i),
+        _mm512_maskz_cvtusepi16_epi8(~0u, _mm512_max_epi16(v, zero)));
+  }
+#elif defined(MYLIB_KERNEL_AVX2)
+  __m256i const qv = _mm256_set1_epi16(static_cast<short>(q));
+  auto load = [](unsigned char const *p) {
+    return _mm256_cvtepu8_epi16(
+        _mm_loadu_si128(reinterpret_cast<__m128i const *>(p)));
+  };
+  for (; i + 16 <= end; i += 16) {
+    __m256i c = load(mid + i);
+    __m256i lap = _mm256_sub_epi16(
+        _mm256_slli_epi16(c, 2),
+        _mm256_add_epi16(_mm256_add_epi16(load(up + i), load(down + i)),
+                         _mm256_add_epi16(load(mid + i - cn),
+                                          load(mid + i + cn))));
+    __m256i v = _mm256_add_epi16(
+        c, _mm256_mulhrs_epi16(_mm256_slli_epi16(lap, kLapShift), qv));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i),
+                     _mm_packus_epi16(_mm256_castsi256_si128(v),
+                                      _mm256_extracti128_si256(v, 1)));
+  }
+#elif defined(MYLIB_KERNEL_SSE2)
+  __m128i const qv = _mm_set1_epi16(static_cast<short>(q));
+  __m128i const zero = _mm_setzero_si128();
+  auto load = [&](unsigned char const *p) {
+    return _mm_unpacklo_epi8(
+        _mm_loadl_epi64(reinterpret_cast<__m128i const *>(p)), zero);
+  };
+  // 8个字节一组
+  auto group = [&](int j) {
+    __m128i c = load(mid + j);
+    __m128i lap = _mm_sub_epi16(
+        _mm_slli_epi16(c, 2),
+        _mm_add_epi16(_mm_add_epi16(load(up + j), load(down + j)),
+                      _mm_add_epi16(load(mid + j - cn), load(mid + j + cn))));
+    return _mm_add_epi16(c, mulhrs(_mm_slli_epi16(lap, kLapShift), qv));
+  };
+  for (; i + 16 <= end; i += 16) {
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i),
+                     _mm_packus_epi16(group(i), group(i + 8)));
+  }
+#endif
+
+  for (; i < end; i++) {
+    out[i] = sharpenScalar(
+        mid[i], up[i] + down[i] + mid[i - cn] + mid[i + cn], q);
+  }
+  for (; i < n; i++) {
+    sharpenEdge(up, mid, down, out, n, cn, q, i);
+  }
+}
+
+void sharpen3x3(unsigned char const *src, size_t src_step, unsigned char *dst,
+                size_t dst_step, int width, int height, int channels,
+                int strength_q10, int row_begin, int row_end) {
+  int const n = width * channels;
+  for (int y = row_begin; y < row_end; y++) {
+    sharpenRow(src + reflect101(y - 1, height) * src_step,
+               src + y * src_step, src + reflect101(y + 1, height) * src_step,
+               dst + y * dst_step, n, channels, strength_q10);
+  }
+}
@@ -1,6 +1,8 @@
 #ifndef INTERFACE_H
 #define INTERFACE_H
 
+#include <stddef.h>
+
 // Windows DLL 导出/导入宏定义
 #ifdef _WIN32
     #ifdef BUILDING_DLL
@@ -17,14 +19,328 @@ extern "C" {
 #endif
 
 struct param {
-  int type{0};   // 0:锐化, 1:对比度, 2:饱和度, 3:亮度
-  int value{50}; // 0-100, 50为默认值
+  // 0:锐化, 1:对比度, 2:饱和度, 3:亮度, 4:自动色阶, 5:降噪(边缘保持),
+  // 6:缩放(Lanczos-3)
+  int type{0};
+  // 0-100, 50为默认值；自动色阶、降噪的 value 为强度，0为默认值(不改变)；
+  // 缩放的 value 为输出尺寸占输入的百分比 1-400，100为默认值，
+  // 每边按四舍五入取整且至少1个像素
+  int value{50};
 };
 
+/**
+ * 与 param.type 按位或，锐化(type 0，value > 50)改用定点整数实现：
+ * 强度量化为 Q10，在 int16 SIMD 通道中计算，与默认的浮点实现相差不超过1，
+ * 可逐次调用对比两者；对其他 type 及模糊(value < 50)没有影响，
+ * 会话接口不接受该标志
+ */
+#define PARAM_FIXED_POINT 0x100
+
+/**
+ * 执行单个调整步骤，结果写入新分配的缓冲区
+ * 输出尺寸与步长与输入相同，缓冲区大小为 height * stride；缩放时输出尺寸
+ * 见 processrgb_chain_size，每行字节数按64字节对齐，
+ * 缓冲区大小为 *output_hight * *output_stride，
+ * 使用完毕后应调用 release_rgb 归还(用 free 释放也安全，但不会被复用)
+ */
 API_EXPORT void processrgb(param p, unsigned char *input_rgb, int width, int height,
                           int stride, int *output_width, int *output_hight,
                           int *output_stride, unsigned char **output_rgb);
 
+/**
+ * 按顺序执行多个调整步骤，只读取一次输入、写出一次结果
+ * value 为默认值的步骤直接跳过；相邻的对比度/亮度步骤合并为一次查找表映射，
+ * 与自动色阶相邻时并入色阶，逐通道一次查表完成
+ * @param params 调整步骤数组
+ * @param count 步骤个数，为0时输出为输入的拷贝
+ * @return 0表示成功，-1表示参数无效或内存不足(此时 *output_rgb 为空)
+ * 输出缓冲区的分配与释放同 processrgb
+ */
+API_EXPORT int processrgb_chain(param const *params, int count,
+                                unsigned char *input_rgb, int width, int height,
+                                int stride, int *output_width,
+                                int *output_hight, int *output_stride,
+                                unsigned char **output_rgb);
+
+/**
+ * 执行单个调整步骤，结果写入调用方提供的缓冲区
+ * output_rgb 可以等于 input_rgb 以原地处理；对比度、亮度、饱和度不产生临时图像
+ * 缩放时输出尺寸由 processrgb_chain_size 得到，缓冲区按输出尺寸提供，
+ * 原地处理时按输入、输出中较大的一个提供
+ * @param output_rgb 至少 output_height * output_stride 字节
+ * @param output_width 输出缓冲区的宽度，必须等于执行后的输出宽度
+ * @param output_height 输出缓冲区的高度，必须等于执行后的输出高度
+ * @param output_stride 输出每行字节数，不小于 output_width * 3
+ * @return 0表示成功，-1表示参数无效或输出尺寸不符
+ */
+API_EXPORT int processrgb_into(param p, unsigned char *input_rgb, int width,
+                               int height, int stride,
+                               unsigned char *output_rgb, int output_width,
+                               int output_height, int output_stride);
+
+/**
+ * processrgb_chain 写入调用方缓冲区的版本，要求同 processrgb_into
+ */
+API_EXPORT int processrgb_chain_into(param const *params, int count,
+                                     unsigned char *input_rgb, int width,
+                                     int height, int stride,
+                                     unsigned char *output_rgb,
+                                     int output_width, int output_height,
+                                     int output_stride);
+
+/**
+ * 计算执行调整步骤后的输出尺寸，只有缩放会改变尺寸
+ * @return 0表示成功，-1表示参数无效
+ */
+API_EXPORT int processrgb_chain_size(param const *params, int count, int width,
+                                     int height, int *output_width,
+                                     int *output_hight);
+
+/**
+ * 归还 processrgb / processrgb_chain 返回的缓冲区，空指针时不做任何事
+ */
+API_EXPORT void release_rgb(unsigned char *output_rgb);
+
+/**
+ * 选择饱和度调整算法，对之后的所有调用生效
+ * @param mode 0: HSV空间(默认，原实现，5次整图遍历)
+ *             1: RGB空间向亮度混合(SIMD定点，最快，观感与HSV略有不同)
+ *             2: RGB空间等效HSV缩放(一次遍历，与0的差异不超过几个灰度级，
+ *                可以用 saturation_accuracy 在实际图像上对比)
+ * 1和2需要显式选择
+ * @return 0表示成功，-1表示 mode 无效
+ */
+API_EXPORT int set_saturation_mode(int mode);
+
+/**
+ * 设置自动色阶(type 4)两端裁剪的像素比例，对之后的所有调用生效
+ * 自动色阶按条带并行统计输入各通道的直方图，每个通道去掉最暗的 low_percent
+ * 和最亮的 high_percent 像素后，把剩余范围线性拉伸到 0-255；value 为拉伸
+ * 结果与原图的混合强度。默认两端各裁剪 0.1%
+ * @return 0表示成功，-1表示比例为负或两者之和不小于100
+ */
+API_EXPORT int set_auto_levels_clip(float low_percent, float high_percent);
+
+/**
+ * 设置内部并行线程数(含调用线程)，图像按水平条带分给常驻工作线程处理，
+ * 结果与单线程逐位一致。默认为1，即全部在调用线程上执行
+ * @param num_threads 小于等于0时使用硬件线程数
+ */
+API_EXPORT void set_num_threads(int num_threads);
+
+/**
+ * 当前内部并行线程数(含调用线程)
+ */
+API_EXPORT int get_num_threads(void);
+
+/**
+ * 像素内核使用的指令集级别，库加载时按 CPU 选定一次
+ * 加载前设置环境变量 MYLIB_CPU_LEVEL=baseline|sse42|avx2|avx512 (或 0-3)
+ * 可以强制使用更低的级别，便于逐一测试；结果在各级别之间逐位一致
+ * @return 0: 基础(SSE2)，1: SSE4.2，2: AVX2，3: AVX-512
+ */
+API_EXPORT int get_cpu_level(void);
+
+/**
+ * 临时图像 arena 的统计
+ * 每次调用内部的临时图像(多步骤之间的中间结果、HSV 模式的通道等)从调用
+ * 线程的 arena 分配，调用结束后整体复用；稳态下 fallbacks 不再增长
+ */
+struct arena_stats {
+  size_t peak_bytes;     // 单个线程的 arena 同时占用的最大字节数
+  size_t reserved_bytes; // 所有线程的 arena 当前向系统申请的总字节数
+  unsigned long long fallbacks; // 调用系统分配器的次数(arena 扩容或超出上限)
+};
+
+/**
+ * 读取 arena 统计
+ */
+API_EXPORT void get_arena_stats(struct arena_stats *stats);
+
+/**
+ * 清零 peak_bytes 和 fallbacks，便于按时间段观察
+ */
+API_EXPORT void reset_arena_stats(void);
+
+/**
+ * 一种操作的累计统计，外层操作的耗时包含其内层操作：
+ * processrgb(processrgb 系列的一次调用、帧流中的一帧)包含 output_alloc 以外的
+ * 各项；其余为 output_alloc、copy、lut(对比度/亮度)、sharpen、sharpen_fixed、
+ * gaussian_blur、box_blur、saturation_hsv(含色彩空间转换)、saturation_rgb、
+ * histogram(自动色阶的直方图)、auto_levels(自动色阶查表)、denoise
+ */
+struct op_stats {
+  char const *name; // 操作名称，静态字符串
+  unsigned long long calls;
+  unsigned long long total_ns;
+  unsigned long long max_ns;
+  unsigned long long bytes; // 读写的图像字节数
+};
+
+/**
+ * 读取各操作的统计(各线程的计数在读取时合并)
+ * @param stats 至少 capacity 个元素，按固定顺序写入前 capacity 种操作
+ * @return 操作的种数；编译时关闭 MYLIB_ENABLE_STATS 时为0
+ */
+API_EXPORT int get_op_stats(struct op_stats *stats, int capacity);
+
+/**
+ * 清零各操作的统计
+ */
+API_EXPORT void reset_op_stats(void);
+
+/**
+ * 编辑会话：保存源图像和每个阶段的中间结果，参数变化时只重算受影响的阶段
+ * 阶段按固定顺序执行(自动色阶、降噪、锐化、对比度、饱和度、亮度)，
+ * value 为默认值的阶段跳过；自动色阶使用源图像的直方图，在会话中只统计一次，
+ * 预览也使用它；会话不支持缩放(type 6)；
+ * 同一会话不能被多个线程同时调用，不同会话之间互不影响
+ */
+typedef struct edit_session edit_session;
+
+/**
+ * 创建编辑会话，会话保存一份源图像的拷贝，调用后 input_rgb 可以释放
+ * @param memory_limit 会话最多保留的字节数(含源图像)，为0时不限制；
+ *        源图像和最近一次的结果总会保留，超出时丢弃中间结果，之后按需重算
+ * @return 会话句柄，参数无效时为空
+ */
+API_EXPORT edit_session *create_session(unsigned char const *input_rgb,
+                                        int width, int height, int stride,
+                                        size_t memory_limit);
+
+/**
+ * 设置一个阶段的参数，只记录不计算；与当前值相同时不做任何事
+ * @return 0表示成功，-1表示参数无效
+ */
+API_EXPORT int session_set_param(edit_session *session, param p);
+
+/**
+ * 按当前参数生成结果，从最后一个仍然有效的中间结果开始计算
+ * 参数未变化时直接返回上次的结果
+ * @param output_rgb 结果由会话持有，在该会话下一次 session_set_param、
+ *        session_render、session_render_preview 或 destroy_session 之前有效
+ * @return 0表示成功，-1表示参数无效
+ */
+API_EXPORT int session_render(edit_session *session, int *output_width,
+                              int *output_hight, int *output_stride,
+                              unsigned char const **output_rgb);
+
+/**
+ * 生成交互预览：在源图像金字塔中不小于视口的最小一层上执行各阶段，
+ * 模糊半径和锐化强度随层的缩放比例调整，使预览与最终结果观感一致
+ * 金字塔在首次预览时按需生成并保留在会话中，预览的中间结果单独缓存；
+ * 原图分辨率的结果需要显式调用 session_render 生成
+ * @param viewport_width 视口宽度，视口不小于源图像时等同于 session_render
+ * @param viewport_height 视口高度
+ * @param output_rgb 结果由会话持有，有效期同 session_render
+ * @return 0表示成功，-1表示参数无效
+ */
+API_EXPORT int session_render_preview(edit_session *session,
+                                      int viewport_width, int viewport_height,
+                                      int *output_width, int *output_hight,
+                                      int *output_stride,
+                                      unsigned char const **output_rgb);
+
+/**
+ * 会话当前保留的内存字节数(源图像及其金字塔、中间结果和最终结果)
+ */
+API_EXPORT size_t session_memory_usage(edit_session const *session);
+
+/**
+ * 销毁会话并释放其全部内存，空指针时不做任何事
+ */
+API_EXPORT void destroy_session(edit_session *session);
+
+/**
+ * 帧流：用于视频等连续帧的异步处理。帧提交到有界的环形队列后立即返回，
+ * 由流自己的处理线程并发处理，结果按提交顺序通过回调交付或由调用方轮询
+ * 同一个流中的帧尺寸相同，各帧使用提交时的调整步骤(见 stream_set_params)；
+ * 输出与输入尺寸相同，调整步骤中不能有缩放(type 6)
+ */
+typedef struct frame_stream frame_stream;
+
+/**
+ * 一帧的处理结果
+ */
+struct stream_frame {
+  unsigned long long sequence; // 提交序号，从0开始连续递增
+  int status;                  // 0表示成功，-1表示内存不足
+  unsigned char *input_rgb;    // 提交时的输入，交付后调用方可以复用
+  unsigned char *output_rgb;   // 提交时的输出；提交时为空则来自缓冲池，
+                               // 需要调用 release_rgb 归还
+  int output_stride;
+  void *user_data;   // 提交时传入
+  double latency_ms; // 从提交到处理完成的时间
+};
+
+/**
+ * 交付回调，在处理线程上按序号顺序逐个调用，同一时间最多一个；
+ * 回调返回后该帧的槽位才空出。回调中不能阻塞等待提交，否则会死锁
+ */
+typedef void (*stream_callback)(void *context,
+                                struct stream_frame const *frame);
+
+struct stream_options {
+  int width{0};
+  int height{0};
+  int stride{0};    // 输入每行字节数，缓冲池分配的输出也使用该步长
+  int ring_size{4}; // 已提交但未交付的帧数上限，队列满时提交会等待或失败
+  // 并发处理的帧数；小于等于0时使用硬件线程数，不超过 ring_size
+  // 取1并配合 set_num_threads 把每帧切成条带并行，单帧延迟最低；
+  // 增大后多帧重叠处理，吞吐更高但每帧延迟变长(同一时间只有一帧使用条带并行)
+  int workers{1};
+  stream_callback callback{nullptr}; // 为空时用 stream_poll 取结果
+  void *context{nullptr};            // 传给 callback
+};
+
+/**
+ * 创建帧流
+ * @param params 调整步骤，含义同 processrgb_chain
+ * @return 流句柄，参数无效时为空
+ */
+API_EXPORT frame_stream *create_stream(param const *params, int count,
+                                       struct stream_options const *options);
+
+/**
+ * 修改调整步骤，对之后提交的帧生效，已提交的帧不受影响
+ * @return 0表示成功，-1表示参数无效
+ */
+API_EXPORT int stream_set_params(frame_stream *stream, param const *params,
+                                 int count);
+
+/**
+ * 提交一帧；input_rgb 和 output_rgb 在该帧交付之前必须保持有效
+ * @param output_rgb 结果写入的缓冲区，可以等于 input_rgb；为空时从缓冲池分配
+ * @param output_stride 输出每行字节数，output_rgb 非空时不小于 width * 3
+ * @param timeout_ms 队列满时最多等待的毫秒数，0表示不等待，负数表示一直等待
+ * @param sequence 非空时写入该帧的序号
+ * @return 0表示成功，1表示队列已满(超时)，-1表示参数无效
+ */
+API_EXPORT int stream_submit(frame_stream *stream, unsigned char *input_rgb,
+                             unsigned char *output_rgb, int output_stride,
+                             void *user_data, int timeout_ms,
+                             unsigned long long *sequence);
+
+/**
+ * 按序号顺序取下一帧的结果，只用于没有设置回调的流
+ * @param timeout_ms 下一帧尚未完成时最多等待的毫秒数，含义同 stream_submit
+ * @return 0表示成功，1表示超时，-1表示参数无效
+ */
+API_EXPORT int stream_poll(frame_stream *stream, struct stream_frame *frame,
+                           int timeout_ms);
+
+/**
+ * 等待已提交的帧全部处理完成；设置了回调时同时等待回调全部返回
+ * @return 0表示成功，-1表示参数无效
+ */
+API_EXPORT int stream_flush(frame_stream *stream);
+
+/**
+ * 处理完已提交的帧后销毁流(设置了回调时照常交付)；未被取走的
+ * 缓冲池输出会被归还。空指针时不做任何事
+ */
+API_EXPORT void destroy_stream(frame_stream *stream);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,4 @@
+// AVX2 版本，用 -mavx2 或 /arch:AVX2 编译本文件
+#define MYLIB_KERNEL_NS kernels_avx2
+#define MYLIB_KERNEL_AVX2 1
+#include "kernels_impl.h"
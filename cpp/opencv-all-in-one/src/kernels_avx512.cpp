@@ -0,0 +1,5 @@
+// AVX-512 版本，用 -mavx512f -mavx512bw -mavx512vl -mavx512dq 或
+// /arch:AVX512 编译本文件
+#define MYLIB_KERNEL_NS kernels_avx512
+#define MYLIB_KERNEL_AVX512 1
+#include "kernels_impl.h"
@@ -0,0 +1,3 @@
+// 基础版本：x86-64 上只使用必备的 SSE2，其他架构为纯标量，总是可用
+#define MYLIB_KERNEL_NS kernels_baseline
+#include "kernels_impl.h"
@@ -0,0 +1,111 @@
+// 像素内核的实现，由每个 kernels_*.cpp 以不同的指令集选项各编译一次
+// 包含前需要定义 MYLIB_KERNEL_NS (该版本的命名空间)，并按需定义
+// MYLIB_KERNEL_SSE41 / MYLIB_KERNEL_AVX2 / MYLIB_KERNEL_AVX512 声明可用的
+// 指令集。不依赖 __AVX2__ 之类的编译器宏，因为 MSVC 没有 SSE4 的 /arch 选项，
+// 也不定义对应的宏
+//
+// 注意：这里不能使用 std::vector、std::min 等标准库模板或内联函数。它们的
+// 实例在每个编译单元中各生成一份、链接时只保留其中任意一份，如果保留的是
+// AVX-512 编译单元里的版本，基础版本的内核在旧 CPU 上也会执行到 AVX-512
+// 指令。只使用本文件内(位于各自命名空间中)的辅助函数和 C 库函数
+
+#ifndef MYLIB_KERNEL_NS
+#error "kernels_impl.h 只能由 kernels_*.cpp 包含"
+#endif
+
+#include "dispatch.h"
+#include "fast_blur.h"
+#include "fixed_sharpen.h"
+#include "lut.h"
+#include "resample.h"
+#include "saturation.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <new>
+
+#if defined(MYLIB_KERNEL_AVX512) && !defined(MYLIB_KERNEL_AVX2)
+#define MYLIB_KERNEL_AVX2 1
+#endif
+#if defined(MYLIB_KERNEL_AVX2) && !defined(MYLIB_KERNEL_SSE41)
+#define MYLIB_KERNEL_SSE41 1
+#endif
+#if defined(MYLIB_KERNEL_SSE41) || defined(__SSE2__) || defined(_M_X64) ||    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MYLIB_KERNEL_SSE2 1
+#endif
+
+#if defined(MYLIB_KERNEL_SSE2)
+#include <immintrin.h>
+#endif
+
+namespace MYLIB_KERNEL_NS {
+namespace {
+
+inline int minOf(int a, int b) { return a < b ? a : b; }
+
+inline int maxOf(int a, int b) { return a > b ? a : b; }
+
+/**
+ * BORDER_REFLECT_101 下标映射，允许越界多次
+ */
+inline int reflect101(int i, int n) {
+  if (n == 1) {
+    return 0;
+  }
+  int period = 2 * (n - 1);
+  i %= period;
+  if (i < 0) {
+    i += period;
+  }
+  return i < n ? i : period - i;
+}
+
+/**
+ * 按64字节对齐的临时缓冲区，代替内核中不能使用的 std::vector
+ * 元素不做初始化，分配失败时抛出 std::bad_alloc
+ */
+template <typename T> class scratch {
+public:
+  explicit scratch(size_t n) : raw_(::operator new(n * sizeof(T) + 64)) {
+    uintptr_t p = reinterpret_cast<uintptr_t>(raw_);
+    data_ = reinterpret_cast<T *>((p + 63) & ~static_cast<uintptr_t>(63));
+  }
+  ~scratch() { ::operator delete(raw_); }
+  scratch(scratch const &) = delete;
+  scratch &operator=(scratch const &) = delete;
+
+  T *data() { return data_; }
+
+private:
+  void *raw_;
+  T *data_;
+};
+
+#include "copy_kernels.h"
+#include "fast_blur_kernels.h"
+#include "fixed_sharpen_kernels.h"
+#include "lut_kernels.h"
+#include "resample_kernels.h"
+#include "saturation_kernels.h"
+
+} // namespace
+
+extern KernelTable const table;
+KernelTable const table = {
+#if defined(MYLIB_KERNEL_AVX512)
+    CpuLevel::avx512, "avx512",
+#elif defined(MYLIB_KERNEL_AVX2)
+    CpuLevel::avx2, "avx2",
+#elif defined(MYLIB_KERNEL_SSE41)
+    CpuLevel::sse42, "sse42",
+#else
+    CpuLevel::baseline, "baseline",
+#endif
+    &applyLut,    &saturateRow,     &boxBlur, &sharpen3x3, &copyRows,
+    &resampleRow, &resampleColumns,
+};
+
+} // namespace MYLIB_KERNEL_NS
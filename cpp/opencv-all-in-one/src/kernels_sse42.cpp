@@ -0,0 +1,5 @@
+// SSE4.2 版本(内核实际用到 SSSE3 和 SSE4.1)
+// GCC/Clang 用 -msse4.2 编译本文件；MSVC 无需选项即可使用这些指令
+#define MYLIB_KERNEL_NS kernels_sse42
+#define MYLIB_KERNEL_SSE41 1
+#include "kernels_impl.h"
@@ -0,0 +1,123 @@
+#include "levels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+ChannelHistogram &ChannelHistogram::operator+=(ChannelHistogram const &other) {
+  for (int c = 0; c < 3; c++) {
+    for (int k = 0; k < 256; k++) {
+      bins[c][k] += other.bins[c][k];
+    }
+  }
+  return *this;
+}
+
+void accumulateHistogram(unsigned char const *src, size_t step, int width,
+                         int rows, ChannelHistogram &hist) {
+  // 相邻像素交替计入两组计数，相同取值连续出现时不必等待上一次累加
+  // 写回(平坦区域很常见)；一次调用只统计一个条带，像素数远小于 2^32
+  uint32_t counts[2][3][256];
+  std::memset(counts, 0, sizeof(counts));
+  for (int y = 0; y < rows; y++) {
+    unsigned char const *p = src + step * y;
+    int x = 0;
+    for (; x + 2 <= width; x += 2, p += 6) {
+      counts[0][0][p[0]]++;
+      counts[0][1][p[1]]++;
+      counts[0][2][p[2]]++;
+      counts[1][0][p[3]]++;
+      counts[1][1][p[4]]++;
+      counts[1][2][p[5]]++;
+    }
+    if (x < width) {
+      counts[0][0][p[0]]++;
+      counts[0][1][p[1]]++;
+      counts[0][2][p[2]]++;
+    }
+  }
+  for (int c = 0; c < 3; c++) {
+    for (int k = 0; k < 256; k++) {
+      hist.bins[c][k] += counts[0][c][k] + counts[1][c][k];
+    }
+  }
+}
+
+ChannelHistogram remapHistogram(ChannelHistogram const &hist,
+                                LutTable const &lut) {
+  ChannelHistogram out{};
+  for (int c = 0; c < 3; c++) {
+    for (int k = 0; k < 256; k++) {
+      out.bins[c][lut.data[k]] += hist.bins[c][k];
+    }
+  }
+  return out;
+}
+
+void autoLevelsLut(ChannelHistogram const &hist, int value, float low,
+                   float high, ChannelLut &lut) {
+  float strength = std::clamp(value, 0, 100) / 100.0f;
+  for (int c = 0; c < 3; c++) {
+    uint64_t const *bins = hist.bins[c];
+    uint64_t total = 0;
+    for (int k = 0; k < 256; k++) {
+      total += bins[k];
+    }
+
+    // lo 为累计数首次超过暗端裁剪量的取值，hi 同理从亮端数起
+    double lowCount = total * (low / 100.0);
+    double highCount = total * (high / 100.0);
+    int lo = 0;
+    for (uint64_t sum = bins[0]; lo < 255 && sum <= lowCount;) {
+      sum += bins[++lo];
+    }
+    int hi = 255;
+    for (uint64_t sum = bins[255]; hi > 0 && sum <= highCount;) {
+      sum += bins[--hi];
+    }
+
+    unsigned char *t = lut.channels[c].data;
+    if (total == 0 || hi <= lo) {
+      for (int k = 0; k < 256; k++) {
+        t[k] = static_cast<unsigned char>(k);
+      }
+      continue;
+    }
+    float gain = 255.0f / (hi - lo);
+    for (int k = 0; k < 256; k++) {
+      float stretched = std::clamp((k - lo) * gain, 0.0f, 255.0f);
+      float v = k + (stretched - k) * strength;
+      t[k] = static_cast<unsigned char>(std::lrintf(v));
+    }
+  }
+}
+
+void applyChannelLut(unsigned char const *src, unsigned char *dst, int pixels,
+                     ChannelLut const &lut) {
+  unsigned char const *t0 = lut.channels[0].data;
+  unsigned char const *t1 = lut.channels[1].data;
+  unsigned char const *t2 = lut.channels[2].data;
+  int i = 0;
+  for (; i + 2 <= pixels; i += 2, src += 6, dst += 6) {
+    unsigned char a = t0[src[0]];
+    unsigned char b = t1[src[1]];
+    unsigned char c = t2[src[2]];
+    unsigned char d = t0[src[3]];
+    unsigned char e = t1[src[4]];
+    unsigned char f = t2[src[5]];
+    dst[0] = a;
+    dst[1] = b;
+    dst[2] = c;
+    dst[3] = d;
+    dst[4] = e;
+    dst[5] = f;
+  }
+  if (i < pixels) {
+    unsigned char a = t0[src[0]];
+    unsigned char b = t1[src[1]];
+    unsigned char c = t2[src[2]];
+    dst[0] = a;
+    dst[1] = b;
+    dst[2] = c;
+  }
+}
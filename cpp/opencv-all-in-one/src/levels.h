@@ -0,0 +1,54 @@
+#ifndef LEVELS_H
+#define LEVELS_H
+
+#include "lut.h"
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * 三通道交错图像各通道的直方图，通道按像素内的字节顺序排列
+ */
+struct ChannelHistogram {
+  uint64_t bins[3][256];
+
+  ChannelHistogram &operator+=(ChannelHistogram const &other);
+};
+
+/**
+ * 每个通道一张查找表，通道顺序同 ChannelHistogram
+ */
+struct ChannelLut {
+  LutTable channels[3];
+};
+
+/**
+ * 把 rows 行三通道像素累加到 hist
+ * @param step 每行字节数
+ */
+void accumulateHistogram(unsigned char const *src, size_t step, int width,
+                         int rows, ChannelHistogram &hist);
+
+/**
+ * 经过查找表 lut 映射后图像的直方图，不必重新统计像素
+ */
+ChannelHistogram remapHistogram(ChannelHistogram const &hist,
+                                LutTable const &lut);
+
+/**
+ * 由直方图生成自动色阶：每个通道两端分别裁剪 low、high 百分比的像素后，
+ * 把剩余范围线性拉伸到 [0, 255]；范围退化(如纯色图像)的通道保持不变
+ * @param value 强度 0-100，结果为原值与拉伸值按 value/100 的混合，0 不改变
+ * @param low 暗端裁剪的百分比
+ * @param high 亮端裁剪的百分比
+ */
+void autoLevelsLut(ChannelHistogram const &hist, int value, float low,
+                   float high, ChannelLut &lut);
+
+/**
+ * 对一行三通道像素逐通道查表，允许 src 与 dst 相同
+ */
+void applyChannelLut(unsigned char const *src, unsigned char *dst, int pixels,
+                     ChannelLut const &lut);
+
+#endif // LEVELS_H
@@ -0,0 +1,120 @@
+#include "lut.h"
+
+#include "dispatch.h"
+
+#include <cmath>
+#include <cstdint>
+#include <list>
+#include <mutex>
+
+namespace {
+
+enum class LutKind : uint32_t { contrast = 1, brightness = 2, combined = 3 };
+
+/**
+ * 查找表的键，保留完整的参数值，不同的参数不会共用一张表
+ */
+struct LutKey {
+  LutKind kind;
+  int a;
+  int b;
+
+  bool operator==(LutKey const &) const = default;
+};
+
+/**
+ * 按键缓存最近使用的查找表，容量很小，命中时只需一次加锁
+ */
+class LutCache {
+public:
+  template <typename Build>
+  std::shared_ptr<LutTable const> get(LutKey key, Build build) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+      if (it->first == key) {
+        entries_.splice(entries_.begin(), entries_, it);
+        return it->second;
+      }
+    }
+
+    auto table = std::make_shared<LutTable>();
+    build(table->data);
+    entries_.emplace_front(key, table);
+    if (entries_.size() > kCapacity) {
+      entries_.pop_back();
+    }
+    return table;
+  }
+
+private:
+  static constexpr size_t kCapacity = 32;
+  std::mutex mutex_;
+  std::list<std::pair<LutKey, std::shared_ptr<LutTable const>>> entries_;
+};
+
+LutCache &cache() {
+  static LutCache instance;
+  return instance;
+}
+
+LutKey makeKey(LutKind kind, int a, int b = 0) { return LutKey{kind, a, b}; }
+
+/**
+ * 单精度乘加后四舍六入五成双并饱和到 [0, 255]，与 convertTo 的取整一致
+ */
+unsigned char saturateRound(float v) {
+  long r = std::lrintf(v);
+  return static_cast<unsigned char>(r < 0 ? 0 : (r > 255 ? 255 : r));
+}
+
+void buildContrast(int value, unsigned char *lut) {
+  // 将0-100映射到0.1-3.0的对比度系数
+  double alpha = value / 50.0;
+  if (alpha > 1.0) {
+    alpha = 1.0 + (alpha - 1.0) * 2.0;
+  } else {
+    alpha = 0.1 + alpha * 0.9;
+  }
+  float a = static_cast<float>(alpha);
+  for (int i = 0; i < 256; i++) {
+    lut[i] = saturateRound(i * a);
+  }
+}
+
+void buildBrightness(int value, unsigned char *lut) {
+  // 将0-100映射到-100到+100的亮度偏移
+  float beta = static_cast<float>((value - 50) * 2.0);
+  for (int i = 0; i < 256; i++) {
+    lut[i] = saturateRound(i + beta);
+  }
+}
+
+} // namespace
+
+std::shared_ptr<LutTable const> contrastLut(int value) {
+  return cache().get(makeKey(LutKind::contrast, value),
+                     [&](unsigned char *lut) { buildContrast(value, lut); });
+}
+
+std::shared_ptr<LutTable const> brightnessLut(int value) {
+  return cache().get(makeKey(LutKind::brightness, value),
+                     [&](unsigned char *lut) { buildBrightness(value, lut); });
+}
+
+std::shared_ptr<LutTable const> contrastBrightnessLut(int contrast,
+                                                      int brightness) {
+  return cache().get(makeKey(LutKind::combined, contrast, brightness),
+                     [&](unsigned char *lut) {
+                       unsigned char b[256];
+                       buildContrast(contrast, lut);
+                       buildBrightness(brightness, b);
+                       for (int i = 0; i < 256; i++) {
+                         lut[i] = b[lut[i]];
+                       }
+                     });
+}
+
+void applyLut(unsigned char const *src, unsigned char *dst, size_t n,
+              LutTable const &lut) {
+  kernels().applyLut(src, dst, n, lut);
+}
@@ -0,0 +1,39 @@
+#ifndef LUT_H
+#define LUT_H
+
+#include <cstddef>
+#include <memory>
+
+/**
+ * 8位查找表，每个输入值对应一个输出值
+ */
+struct LutTable {
+  alignas(64) unsigned char data[256];
+};
+
+/**
+ * 获取对比度调整的查找表，按值缓存
+ * @param value 对比度值 0-100
+ */
+std::shared_ptr<LutTable const> contrastLut(int value);
+
+/**
+ * 获取亮度调整的查找表，按值缓存
+ * @param value 亮度值 0-100
+ */
+std::shared_ptr<LutTable const> brightnessLut(int value);
+
+/**
+ * 获取先对比度后亮度的复合查找表，按 (对比度, 亮度) 缓存
+ * 结果与依次执行两次调整(每次都饱和截断)完全一致
+ */
+std::shared_ptr<LutTable const> contrastBrightnessLut(int contrast,
+                                                      int brightness);
+
+/**
+ * 对连续的 n 个字节做查表映射，允许 src 与 dst 相同
+ */
+void applyLut(unsigned char const *src, unsigned char *dst, size_t n,
+              LutTable const &lut);
+
+#endif // LUT_H
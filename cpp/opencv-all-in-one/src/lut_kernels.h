@@ -0,0 +1,81 @@
+// 查找表内核，只能由 kernels_impl.h 在各版本的命名空间内包含
+
+void applyLut(unsigned char const *src, unsigned char *dst, size_t n,
+              LutTable const &lut) {
+  unsigned char const *t = lut.data;
+  size_t i = 0;
+
+  // 把256项表拆成16段、每段16项，用 pshufb 分别查表：
+  // idx = x - 16*h 落在 [0,15] 时饱和加 0x70 后最高位为0，否则为1，
+  // pshufb 对最高位为1的索引输出0，因此16次查表结果按位或即为答案
+#if defined(MYLIB_KERNEL_AVX512)
+  {
+    __m512i seg[16];
+    for (int h = 0; h < 16; h++) {
+      // 不带掩码的版本在 GCC 12 的头文件中会触发未初始化警告
+      seg[h] = _mm512_maskz_broadcast_i32x4(
+          0xffff,
+          _mm_load_si128(reinterpret_cast<__m128i const *>(t + h * 16)));
+    }
+    __m512i const bias = _mm512_set1_epi8(0x70);
+    __m512i const step = _mm512_set1_epi8(16);
+    for (; i + 128 <= n; i += 128) {
+      __m512i x0 = _mm512_loadu_si512(src + i);
+      __m512i x1 = _mm512_loadu_si512(src + i + 64);
+      __m512i acc0 = _mm512_setzero_si512();
+      __m512i acc1 = _mm512_setzero_si512();
+      for (int h = 0; h < 16; h++) {
+        acc0 = _mm512_or_si512(
+            acc0, _mm512_shuffle_epi8(seg[h], _mm512_adds_epu8(x0, bias)));
+        acc1 = _mm512_or_si512(
+            acc1, _mm512_shuffle_epi8(seg[h], _mm512_adds_epu8(x1, bias)));
+        x0 = _mm512_sub_epi8(x0, step);
+        x1 = _mm512_sub_epi8(x1, step);
+      }
+      _mm512_storeu_si512(dst + i, acc0);
+      _mm512_storeu_si512(dst + i + 64, acc1);
+    }
+  }
+#endif
+#if defined(MYLIB_KERNEL_AVX2)
+  __m256i seg[16];
+  for (int h = 0; h < 16; h++) {
+    seg[h] = _mm256_broadcastsi128_si256(
+        _mm_load_si128(reinterpret_cast<__m128i const *>(t + h * 16)));
+  }
+  __m256i const bias = _mm256_set1_epi8(0x70);
+  __m256i const step = _mm256_set1_epi8(16);
+  // 两组互不依赖的查表交错执行，掩盖 or/sub 依赖链的延迟
+  for (; i + 64 <= n; i += 64) {
+    __m256i x0 = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(src + i));
+    __m256i x1 =
+        _mm256_loadu_si256(reinterpret_cast<__m256i const *>(src + i + 32));
+    __m256i acc0 = _mm256_setzero_si256();
+    __m256i acc1 = _mm256_setzero_si256();
+    for (int h = 0; h < 16; h++) {
+      acc0 = _mm256_or_si256(
+          acc0, _mm256_shuffle_epi8(seg[h], _mm256_adds_epu8(x0, bias)));
+      acc1 = _mm256_or_si256(
+          acc1, _mm256_shuffle_epi8(seg[h], _mm256_adds_epu8(x1, bias)));
+      x0 = _mm256_sub_epi8(x0, step);
+      x1 = _mm256_sub_epi8(x1, step);
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), acc0);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i + 32), acc1);
+  }
+#endif
+
+  for (; i + 4 <= n; i += 4) {
+    unsigned char a = t[src[i]];
+    unsigned char b = t[src[i + 1]];
+    unsigned char c = t[src[i + 2]];
+    unsigned char d = t[src[i + 3]];
+    dst[i] = a;
+    dst[i + 1] = b;
+    dst[i + 2] = c;
+    dst[i + 3] = d;
+  }
+  for (; i < n; i++) {
+    dst[i] = t[src[i]];
+  }
+}
@@ -1,242 +1,383 @@
+#include <interface.h>
+
+#include "bounded_queue.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
 #include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include <opencv2/opencv.hpp>
 
+namespace fs = std::filesystem;
+
 /**
- * 图像锐化处理
- * @param src 输入图像
- * @param value 锐化程度 0-100，50为默认值(不改变)
- * @return 处理后的图像
+ * 一个阶段的累计统计，各线程并发累加
  */
-cv::Mat sharpen(cv::Mat const &src, int value = 50) {
-  if (value == 50) {
-    return src.clone();
+struct stageStats {
+  std::atomic<long long> items{0};
+  std::atomic<long long> pixels{0};
+  std::atomic<long long> nanos{0}; // 各线程实际工作时间之和
+  std::atomic<long long> failures{0};
+
+  void add(long long px, std::chrono::steady_clock::duration busy) {
+    items += 1;
+    pixels += px;
+    nanos += std::chrono::duration_cast<std::chrono::nanoseconds>(busy).count();
   }
+};
 
-  cv::Mat result;
-  cv::Mat kernel;
+struct options {
+  std::vector<fs::path> inputs;
+  std::vector<param> ops;
+  fs::path outputDir{"."};
+  std::string format{"png"};
+  int compression{-1}; // -1 表示使用编码器默认值
+  int workers{0};
+  int decoders{0};
+  int encoders{0};
+  int queue{0};
+};
 
-  if (value > 50) {
-    // 锐化核心，value越大锐化程度越强
-    float strength = (value - 50) / 50.0f * 2.0f; // 0-2范围
-    kernel = (cv::Mat_<float>(3, 3) << 0, -strength, 0, -strength,
-              1 + 4 * strength, -strength, 0, -strength, 0);
-  } else {
-    // 模糊处理，value越小模糊程度越强
-    float strength = (50 - value) / 50.0f * 10.0f + 1.0f; // 1-11范围
-    cv::GaussianBlur(src, result, cv::Size(0, 0), strength);
-    return result;
-  }
+// 一幅已解码的输入图像，被它的所有操作共享
+struct decoded {
+  std::string stem;
+  cv::Mat rgb;
+};
 
-  cv::filter2D(src, result, src.depth(), kernel);
-  return result;
+struct task {
+  std::shared_ptr<decoded const> image;
+  param op;
+  cv::Mat result;
+};
+
+static void usage(char const *prog) {
+  std::cout
+      << "用法: " << prog << " [选项] [图像或目录...]\n"
+      << "  -o, --output <目录>      输出目录，默认为当前目录\n"
+      << "  -l, --list <文件>        从文件读取输入路径，每行一个\n"
+      << "  -p, --op <type:value>    要执行的操作，可重复或用逗号分隔，\n"
+      << "                           默认为 type 0-3 × value 0,10,...,100\n"
+      << "  -f, --format <扩展名>    输出格式 png/jpg/webp/bmp，默认 png\n"
+      << "  -c, --compression <n>    PNG 压缩级别 0-9，或 JPEG/WebP 质量 "
+         "0-100\n"
+      << "  -j, --threads <n>        处理线程数，默认为硬件线程数\n"
+      << "      --decoders <n>       解码线程数\n"
+      << "      --encoders <n>       编码线程数\n"
+      << "      --queue <n>          阶段之间队列的最大长度\n"
+      << "不带图像参数时处理 ./test.png\n";
 }
 
-/**
- * 对比度调整
- * @param src 输入图像
- * @param value 对比度值 0-100，50为默认值(不改变)
- * @return 处理后的图像
- */
-cv::Mat adjustContrast(cv::Mat const &src, int value = 50) {
-  if (value == 50) {
-    return src.clone();
+static bool isImageFile(fs::path const &path) {
+  std::string ext = path.extension().string();
+  for (char &ch : ext) {
+    ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
   }
-
-  cv::Mat result;
-  // 将0-100映射到0.1-3.0的对比度系数
-  double alpha = value / 50.0;
-  if (alpha > 1.0) {
-    alpha = 1.0 + (alpha - 1.0) * 2.0; // 50-100映射到1.0-3.0
-  } else {
-    alpha = 0.1 + alpha * 0.9; // 0-50映射到0.1-1.0
+  for (char const *known :
+       {".png", ".jpg", ".jpeg", ".bmp", ".tif", ".tiff", ".webp"}) {
+    if (ext == known) {
+      return true;
+    }
   }
-
-  src.convertTo(result, -1, alpha, 0);
-  return result;
+  return false;
 }
 
 /**
- * 饱和度调整
- * @param src 输入图像
- * @param value 饱和度值 0-100，50为默认值(不改变)
- * @return 处理后的图像
+ * 解析 "type:value[,type:value...]"
  */
-cv::Mat adjustSaturation(cv::Mat const &src, int value = 50) {
-  if (value == 50) {
-    return src.clone();
+static bool parseOps(std::string const &text, std::vector<param> &ops) {
+  size_t pos = 0;
+  while (pos <= text.size()) {
+    size_t end = text.find(',', pos);
+    if (end == std::string::npos) {
+      end = text.size();
+    }
+    param p;
+    if (std::sscanf(text.substr(pos, end - pos).c_str(), "%d:%d", &p.type,
+                    &p.value) != 2) {
+      return false;
+    }
+    ops.push_back(p);
+    pos = end + 1;
   }
+  return true;
+}
 
-  cv::Mat result;
-  cv::Mat hsv;
-
-  // 转换到HSV色彩空间
-  cv::cvtColor(src, hsv, cv::COLOR_BGR2HSV);
-
-  // 分离通道
-  std::vector<cv::Mat> channels;
-  cv::split(hsv, channels);
-
-  // 调整饱和度通道(S通道)
-  double saturation_factor = value / 50.0;
-  if (saturation_factor > 1.0) {
-    saturation_factor =
-        1.0 + (saturation_factor - 1.0) * 2.0; // 50-100映射到1.0-3.0
+static void addInput(fs::path const &path, std::vector<fs::path> &inputs) {
+  std::error_code ec;
+  if (fs::is_directory(path, ec)) {
+    std::vector<fs::path> files;
+    for (auto const &entry : fs::directory_iterator(path, ec)) {
+      if (entry.is_regular_file() && isImageFile(entry.path())) {
+        files.push_back(entry.path());
+      }
+    }
+    std::sort(files.begin(), files.end());
+    inputs.insert(inputs.end(), files.begin(), files.end());
   } else {
-    saturation_factor = saturation_factor; // 0-50映射到0.0-1.0
+    inputs.push_back(path);
   }
-
-  channels[1].convertTo(channels[1], -1, saturation_factor, 0);
-
-  // 合并通道
-  cv::merge(channels, hsv);
-
-  // 转换回BGR色彩空间
-  cv::cvtColor(hsv, result, cv::COLOR_HSV2BGR);
-  return result;
 }
 
 /**
- * 亮度调整
- * @param src 输入图像
- * @param value 亮度值 0-100，50为默认值(不改变)
- * @return 处理后的图像
+ * @return false 表示参数有误，已输出原因
  */
-cv::Mat adjustBrightness(cv::Mat const &src, int value = 50) {
-  if (value == 50) {
-    return src.clone();
-  }
-
-  cv::Mat result;
-  // 将0-100映射到-100到+100的亮度偏移
-  double beta = (value - 50) * 2.0; // -100到+100
+static bool parseArgs(int argc, char **argv, options &opt) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    auto next = [&]() -> char const * {
+      return i + 1 < argc ? argv[++i] : nullptr;
+    };
+    auto number = [&](int &out) {
+      char const *v = next();
+      return v != nullptr && std::sscanf(v, "%d", &out) == 1;
+    };
+
+    bool ok = true;
+    if (arg == "-h" || arg == "--help") {
+      usage(argv[0]);
+      std::exit(0);
+    } else if (arg == "-o" || arg == "--output") {
+      char const *v = next();
+      ok = v != nullptr;
+      if (ok) {
+        opt.outputDir = v;
+      }
+    } else if (arg == "-l" || arg == "--list") {
+      char const *v = next();
+      std::ifstream list(v != nullptr ? v : "");
+      ok = list.is_open();
+      for (std::string line; ok && std::getline(list, line);) {
+        if (!line.empty() && line.back() == '\r') {
+          line.pop_back();
+        }
+        if (!line.empty()) {
+          addInput(line, opt.inputs);
+        }
+      }
+    } else if (arg == "-p" || arg == "--op") {
+      char const *v = next();
+      ok = v != nullptr && parseOps(v, opt.ops);
+    } else if (arg == "-f" || arg == "--format") {
+      char const *v = next();
+      ok = v != nullptr;
+      if (ok) {
+        opt.format = v;
+        if (opt.format == "jpeg") {
+          opt.format = "jpg";
+        }
+      }
+    } else if (arg == "-c" || arg == "--compression") {
+      ok = number(opt.compression);
+    } else if (arg == "-j" || arg == "--threads") {
+      ok = number(opt.workers);
+    } else if (arg == "--decoders") {
+      ok = number(opt.decoders);
+    } else if (arg == "--encoders") {
+      ok = number(opt.encoders);
+    } else if (arg == "--queue") {
+      ok = number(opt.queue);
+    } else if (!arg.empty() && arg[0] == '-') {
+      ok = false;
+    } else {
+      addInput(arg, opt.inputs);
+    }
 
-  src.convertTo(result, -1, 1.0, beta);
-  return result;
-}
+    if (!ok) {
+      std::cerr << "无效的参数: " << arg << std::endl;
+      usage(argv[0]);
+      return false;
+    }
+  }
 
-struct param {
-  int type{0};   // 0:锐化, 1:对比度, 2:饱和度, 3:亮度
-  int value{50}; // 0-100, 50为默认值
-};
+  if (opt.inputs.empty()) {
+    opt.inputs.push_back("./test.png");
+  }
+  if (opt.ops.empty()) {
+    for (int type = 0; type < 4; type++) {
+      for (int value = 0; value <= 100; value += 10) {
+        opt.ops.push_back(param{type, value});
+      }
+    }
+  }
 
-void processrgb(param p, unsigned char *input_rgb, int width, int height,
-                int stride, int *output_width, int *output_hight,
-                int *output_stride, unsigned char **output_rgb) {
-  *output_width = width;
-  *output_hight = height;
-  *output_stride = stride;
-  cv::Mat img(height, width, CV_8UC3, input_rgb, stride);
-  cv::Mat res;
-
-  if (p.type == 0) {
-    res = sharpen(img, p.value);
-  } else if (p.type == 1) {
-    res = adjustContrast(img, p.value);
-  } else if (p.type == 2) {
-    res = adjustSaturation(img, p.value);
-  } else if (p.type == 3) {
-    res = adjustBrightness(img, p.value);
-  } else {
-    return;
+  int hw = std::max(1u, std::thread::hardware_concurrency());
+  if (opt.workers <= 0) {
+    opt.workers = hw;
+  }
+  if (opt.decoders <= 0) {
+    opt.decoders = std::max(1, hw / 4);
   }
-  // copy to output_rgb with stride
-  auto buf = static_cast<unsigned char *>(std::malloc(res.rows * stride * 3));
-  *output_rgb = buf;
-  for (int i = 0; i < res.rows; i++) {
-    memcpy(buf + i * stride, res.ptr(i), res.cols * 3);
+  if (opt.encoders <= 0) {
+    opt.encoders = std::max(1, hw / 2);
   }
+  if (opt.queue <= 0) {
+    opt.queue = 2 * opt.workers;
+  }
+  return true;
 }
 
-void test(std::string path, int type, int value) {
-  cv::Mat img = cv::imread(path);
-  if (img.empty()) {
-    std::cerr << "Error: Could not load image at " << path << std::endl;
-    return;
+static std::vector<int> encodeParams(options const &opt) {
+  if (opt.compression < 0) {
+    return {};
   }
-  cv::Mat rgb;
-  cv::cvtColor(img, rgb, cv::COLOR_BGR2RGB);
-
-  int out_width, out_height, out_stride;
-  unsigned char *out_rgb = nullptr;
-
-  processrgb(param{type, value}, rgb.data, rgb.cols, rgb.rows, rgb.step[0],
-             &out_width, &out_height, &out_stride, &out_rgb);
-  namespace fs = std::filesystem;
-
-  cv::Mat output_image(out_height, out_width, CV_8UC3, out_rgb, out_stride);
-  std::string output_path =
-      "output_" + std::to_string(type) + "_" + std::to_string(value) + ".png";
-  cv::imwrite(output_path, output_image);
+  if (opt.format == "png") {
+    return {cv::IMWRITE_PNG_COMPRESSION, opt.compression};
+  }
+  if (opt.format == "jpg") {
+    return {cv::IMWRITE_JPEG_QUALITY, opt.compression};
+  }
+  if (opt.format == "webp") {
+    return {cv::IMWRITE_WEBP_QUALITY, opt.compression};
+  }
+  return {};
 }
 
-int main() {
-  std::cout << "OpenCV version: " << CV_VERSION << std::endl;
+static void report(char const *name, stageStats const &stats, int threads) {
+  double busy = stats.nanos / 1e9;
+  double mp = stats.pixels / 1e6;
+  double perThread = busy > 0 ? mp / busy : 0;
+  std::printf("%-8s %6lld 项 %5lld 失败 %9.1f MP %8.2f s %8.1f MP/s/线程 "
+              "x%-3d = %8.1f MP/s\n",
+              name, stats.items.load(), stats.failures.load(), mp, busy,
+              perThread, threads, perThread * threads);
+}
 
-  for (int i = 0; i < 4; ++i) {
-    for (int j = 0; j < 110; j += 10) {
-      test("./test.png", i, j);
-    }
+/**
+ * 批量处理：解码、处理、编码三个阶段由有界队列串成流水线并发执行
+ * 每幅图像只解码一次，它的各个操作分散到多个处理线程
+ */
+int main(int argc, char **argv) {
+  options opt;
+  if (!parseArgs(argc, argv, opt)) {
+    return 2;
   }
-  return 0;
+  std::error_code ec;
+  fs::create_directories(opt.outputDir, ec);
 
-  // 读取test.png图像
-  cv::Mat png = cv::imread("./test.png");
+  std::cout << "OpenCV version: " << CV_VERSION << std::endl;
+  std::cout << opt.inputs.size() << " 幅图像 x " << opt.ops.size()
+            << " 个操作, 解码/处理/编码线程 " << opt.decoders << "/"
+            << opt.workers << "/" << opt.encoders << std::endl;
+
+  // 并行度来自同时处理多个任务，库内部不再按条带拆分
+  set_num_threads(1);
+
+  BoundedQueue<task> pending(opt.queue);
+  BoundedQueue<task> finished(opt.queue);
+  stageStats decodeStats, processStats, encodeStats;
+  std::atomic<size_t> nextInput{0};
+  std::vector<int> params = encodeParams(opt);
+  auto start = std::chrono::steady_clock::now();
+
+  auto decode = [&]() {
+    for (size_t i; (i = nextInput++) < opt.inputs.size();) {
+      fs::path const &path = opt.inputs[i];
+      auto t0 = std::chrono::steady_clock::now();
+      cv::Mat bgr = cv::imread(path.string(), cv::IMREAD_COLOR);
+      if (bgr.empty()) {
+        std::cerr << "Error: Could not load image at " << path << std::endl;
+        decodeStats.failures++;
+        continue;
+      }
+      auto image = std::make_shared<decoded>();
+      image->stem = path.stem().string();
+      cv::cvtColor(bgr, image->rgb, cv::COLOR_BGR2RGB);
+      decodeStats.add(bgr.total(), std::chrono::steady_clock::now() - t0);
+
+      for (param op : opt.ops) {
+        pending.push(task{image, op, cv::Mat()});
+      }
+    }
+  };
+
+  auto process = [&]() {
+    for (task t; pending.pop(t);) {
+      auto t0 = std::chrono::steady_clock::now();
+      cv::Mat const &rgb = t.image->rgb;
+      // 缩放会改变尺寸，结果按执行后的输出尺寸分配
+      int w = 0;
+      int h = 0;
+      if (processrgb_chain_size(&t.op, 1, rgb.cols, rgb.rows, &w, &h) == 0) {
+        t.result.create(h, w, CV_8UC3);
+      }
+      if (t.result.empty() ||
+          processrgb_into(t.op, rgb.data, rgb.cols, rgb.rows,
+                          static_cast<int>(rgb.step[0]), t.result.data,
+                          t.result.cols, t.result.rows,
+                          static_cast<int>(t.result.step[0])) != 0) {
+        std::cerr << "Error: invalid op " << t.op.type << ":" << t.op.value
+                  << std::endl;
+        processStats.failures++;
+        continue;
+      }
+      processStats.add(rgb.total(), std::chrono::steady_clock::now() - t0);
+      finished.push(std::move(t));
+    }
+  };
+
+  auto encode = [&]() {
+    for (task t; finished.pop(t);) {
+      auto t0 = std::chrono::steady_clock::now();
+      cv::Mat bgr;
+      cv::cvtColor(t.result, bgr, cv::COLOR_RGB2BGR);
+      fs::path out = opt.outputDir / (t.image->stem + "_" +
+                                      std::to_string(t.op.type) + "_" +
+                                      std::to_string(t.op.value) + "." +
+                                      opt.format);
+      if (!cv::imwrite(out.string(), bgr, params)) {
+        std::cerr << "Error: Could not write " << out << std::endl;
+        encodeStats.failures++;
+        continue;
+      }
+      encodeStats.add(bgr.total(), std::chrono::steady_clock::now() - t0);
+    }
+  };
 
-  if (png.empty()) {
-    std::cout << "Error: Could not load test.png image!" << std::endl;
-    std::cout << "Please make sure test.png exists in the current directory."
-              << std::endl;
-    return -1;
+  std::vector<std::thread> decoders, workers, encoders;
+  for (int i = 0; i < opt.decoders; i++) {
+    decoders.emplace_back(decode);
+  }
+  for (int i = 0; i < opt.workers; i++) {
+    workers.emplace_back(process);
+  }
+  for (int i = 0; i < opt.encoders; i++) {
+    encoders.emplace_back(encode);
   }
 
-  cv::Mat rgb;
-  cv::cvtColor(png, rgb, cv::COLOR_BGR2RGB);
-  assert(rgb.isContinuous() && rgb.type() == CV_8UC3);
-
-  auto data = std::make_unique<unsigned char[]>(rgb.cols * rgb.rows * 3);
-  std::copy(rgb.data, rgb.data + rgb.cols * rgb.rows * 3, data.get());
-  cv::Mat image(rgb.rows, rgb.cols, CV_8UC3, data.get());
-
-  std::cout << "Image size: " << image.cols << "x" << image.rows << std::endl;
-  std::cout << "test.png loaded successfully" << std::endl;
-
-  // 测试图像处理功能
-  std::cout << "\nTesting image processing functions:" << std::endl;
+  // 上游全部结束后关闭队列，下游取空后自然退出
+  for (auto &t : decoders) {
+    t.join();
+  }
+  pending.close();
+  for (auto &t : workers) {
+    t.join();
+  }
+  finished.close();
+  for (auto &t : encoders) {
+    t.join();
+  }
 
-  // 测试锐化
-  cv::Mat sharpened = sharpen(image, 80);
-  cv::imwrite("test_sharpened.png", sharpened);
-  std::cout
-      << "Sharpening completed (strength: 80) - saved as test_sharpened.png"
-      << std::endl;
-
-  // 测试对比度
-  cv::Mat contrasted = adjustContrast(image, 70);
-  cv::imwrite("test_contrasted.png", contrasted);
-  std::cout << "Contrast adjustment completed (strength: 70) - saved as "
-               "test_contrasted.png"
-            << std::endl;
-
-  // 测试饱和度
-  cv::Mat saturated = adjustSaturation(image, 80);
-  cv::imwrite("test_saturated.png", saturated);
-  std::cout << "Saturation adjustment completed (strength: 80) - saved as "
-               "test_saturated.png"
-            << std::endl;
-
-  // 测试亮度
-  cv::Mat brightened = adjustBrightness(image, 70);
-  cv::imwrite("test_brightened.png", brightened);
-  std::cout << "Brightness adjustment completed (strength: 70) - saved as "
-               "test_brightened.png"
-            << std::endl;
-
-  // 保存原图副本作为对比
-  cv::imwrite("test_original.png", image);
-  std::cout << "Original image saved as test_original.png for comparison"
-            << std::endl;
-
-  return 0;
+  double wall = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - start)
+                    .count();
+  std::printf("\n总耗时 %.2f s, 输出 %lld 幅图像 (%.1f 幅/s)\n", wall,
+              encodeStats.items.load(),
+              wall > 0 ? encodeStats.items / wall : 0.0);
+  report("decode", decodeStats, opt.decoders);
+  report("process", processStats, opt.workers);
+  report("encode", encodeStats, opt.encoders);
+
+  long long failures = decodeStats.failures + processStats.failures +
+                       encodeStats.failures;
+  return failures == 0 ? 0 : 1;
 }
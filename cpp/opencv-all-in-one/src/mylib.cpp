@@ -1,83 +1,335 @@
 #include <interface.h>
 
+#include "arena.h"
+#include "buffer_pool.h"
+#include "denoise.h"
+#include "dispatch.h"
+#include "fast_blur.h"
+#include "fixed_sharpen.h"
+#include "levels.h"
+#include "lut.h"
+#include "ops.h"
+#include "resample.h"
+#include "saturation.h"
+#include "stats.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
 #include <filesystem>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 #include <opencv2/opencv.hpp>
 
+/**
+ * GaussianBlur 对8位图像按 sigma 自动选取的核半径
+ */
+static int gaussianRadius(double sigma) {
+  return (cvRound(sigma * 3 * 2 + 1) | 1) / 2;
+}
+
+/**
+ * sigma 不小于该值时用叠加盒式滤波代替 GaussianBlur，耗时不再随 sigma 增长；
+ * 与精确高斯的误差见 README 中的测量结果
+ */
+constexpr float kBoxBlurMinSigma = 4.0f;
+
+static size_t imageBytes(cv::Mat const &img) {
+  return img.empty() ? 0 : img.step[0] * img.rows;
+}
+
+/**
+ * 图像锐化处理，结果写入 dst (dst 已分配且尺寸类型一致时直接复用其内存)
+ * 按水平条带并行；每个条带只写自己的行，OpenCV 会从父图像读取条带外的
+ * halo 行作为邻域，只在整幅图像边缘做边界外推，因此结果与整图处理逐位一致；
+ * sigma 较大时改用 boxBlur，它同样读取整幅 src、只写条带内的行
+ * @param src 输入图像
+ * @param dst 输出图像，不能与 src 共享内存
+ * @param value 锐化程度 0-100，不应为50
+ * @param scale src 相对原图的缩放比例，用于预览：模糊的 sigma 按比例缩小；
+ *        锐化强度按比例的平方衰减(拉普拉斯算子对低频的响应与频率平方成正比，
+ *        原图上被增强的细节缩小后大部分已被滤掉)
+ * @param fixedPoint 为真时锐化(value > 50)改用定点整数的 sharpen3x3，
+ *        与 filter2D 的结果相差不超过1；不影响模糊
+ */
+static void sharpen(cv::Mat const &src, cv::Mat &dst, int value,
+                    float scale = 1.0f, bool fixedPoint = false) {
+  dst.create(src.size(), src.type());
+  cv::Mat kernel;
+  float taps[9];
+  float strength = 0;
+  float sigma = 0;
+  int halo = 1;
+
+  if (value > 50) {
+    // 锐化核心，value越大锐化程度越强
+    strength = (value - 50) / 50.0f * 2.0f; // 0-2范围
+    strength *= scale * scale;
+    float const k[9] = {0, -strength, 0, -strength, 1 + 4 * strength,
+                        -strength, 0, -strength, 0};
+    std::copy(k, k + 9, taps);
+    kernel = cv::Mat(3, 3, CV_32F, taps); // 引用栈上的系数，不分配内存
+  } else {
+    // 模糊处理，value越小模糊程度越强
+    sigma = (50 - value) / 50.0f * 10.0f + 1.0f; // 1-11范围
+    sigma *= scale;
+    halo = gaussianRadius(sigma);
+  }
+
+  bool box =
+      kernel.empty() && sigma >= kBoxBlurMinSigma && src.depth() == CV_8U;
+  BoxBlurPlan plan{};
+  if (box) {
+    plan = boxBlurPlan(sigma);
+    halo = boxBlurHalo(plan);
+  }
+  bool fixed = fixedPoint && !kernel.empty() && src.depth() == CV_8U;
+  MYLIB_TIMED(box              ? Stat::boxBlur
+              : fixed          ? Stat::sharpenFixed
+              : kernel.empty() ? Stat::gaussianBlur
+                               : Stat::sharpen,
+              imageBytes(src) + imageBytes(dst));
+
+  forEachStripe(src.rows, halo, src.total(), [&](int begin, int end) {
+    if (box) {
+      boxBlur(src.data, src.step, dst.data, dst.step, src.cols, src.rows,
+              src.channels(), plan, begin, end);
+      return;
+    }
+    if (fixed) {
+      sharpen3x3(src.data, src.step, dst.data, dst.step, src.cols, src.rows,
+                 src.channels(), strength, begin, end);
+      return;
+    }
+    cv::Mat in = src.rowRange(begin, end);
+    cv::Mat out = dst.rowRange(begin, end);
+    if (kernel.empty()) {
+      cv::GaussianBlur(in, out, cv::Size(0, 0), sigma);
+    } else {
+      cv::filter2D(in, out, src.depth(), kernel);
+    }
+  });
+}
+
 /**
  * 图像锐化处理
  * @param src 输入图像
  * @param value 锐化程度 0-100，50为默认值(不改变)
+ * @param fixedPoint 锐化是否使用定点整数实现
  * @return 处理后的图像
  */
-cv::Mat sharpen(cv::Mat const &src, int value = 50) {
+cv::Mat sharpen(cv::Mat const &src, int value, bool fixedPoint) {
   if (value == 50) {
     return src.clone();
   }
 
   cv::Mat result;
-  cv::Mat kernel;
+  sharpen(src, result, value, 1.0f, fixedPoint);
+  return result;
+}
 
-  if (value > 50) {
-    // 锐化核心，value越大锐化程度越强
-    float strength = (value - 50) / 50.0f * 2.0f; // 0-2范围
-    kernel = (cv::Mat_<float>(3, 3) << 0, -strength, 0, -strength,
-              1 + 4 * strength, -strength, 0, -strength, 0);
-  } else {
-    // 模糊处理，value越小模糊程度越强
-    float strength = (50 - value) / 50.0f * 10.0f + 1.0f; // 1-11范围
-    cv::GaussianBlur(src, result, cv::Size(0, 0), strength);
-    return result;
+/**
+ * 边缘保持降噪(自引导滤波)，dst 已分配且尺寸类型一致时直接复用其内存
+ * 与锐化相同，按水平条带并行，每个条带读取上下 halo 行、只写自己的行，
+ * 结果与整图处理逐位一致
+ * @param src 输入图像
+ * @param dst 输出图像，不能与 src 共享内存
+ * @param value 降噪强度 0-100，不应为0
+ * @param scale src 相对原图的缩放比例，用于预览：窗口半径按比例缩小
+ */
+static void denoise(cv::Mat const &src, cv::Mat &dst, int value,
+                    float scale = 1.0f) {
+  dst.create(src.size(), src.type());
+  MYLIB_TIMED(Stat::denoise, imageBytes(src) + imageBytes(dst));
+  GuidedFilterPlan plan = guidedFilterPlan(value, scale);
+  forEachStripe(src.rows, guidedFilterHalo(plan), src.total(),
+                [&](int begin, int end) {
+                  guidedFilter(src, dst, plan, begin, end);
+                });
+}
+
+/**
+ * 边缘保持降噪
+ * @param src 输入图像
+ * @param value 降噪强度 0-100，0为默认值(不改变)
+ * @return 处理后的图像
+ */
+cv::Mat denoise(cv::Mat const &src, int value) {
+  if (value == 0) {
+    return src.clone();
   }
 
-  cv::filter2D(src, result, src.depth(), kernel);
+  cv::Mat result;
+  denoise(src, result, value);
   return result;
 }
 
 /**
- * 对比度调整
+ * 用 Lanczos-3 缩放到 size，按输出行的条带并行，每个输出行只依赖输入，
+ * 结果与整图处理逐位一致；两个方向的系数按尺寸缓存
+ * 竖直方向缩小时先竖直后水平：逐行得到缩小后的一行、马上做水平缩放，
+ * 逐像素的水平缩放只处理输出行数；竖直方向放大时先对条带所需的输入行做
+ * 水平缩放，放进 arena 分配的临时图像，相邻条带重叠的几行各算一次
  * @param src 输入图像
- * @param value 对比度值 0-100，50为默认值(不改变)
+ * @param dst 输出图像，不能与 src 共享内存；已分配且尺寸类型一致时直接复用
+ * @param size 输出尺寸
+ */
+static void resample(cv::Mat const &src, cv::Mat &dst, cv::Size size) {
+  dst.create(size, src.type());
+  MYLIB_TIMED(Stat::resample, imageBytes(src) + imageBytes(dst));
+  auto ax = resampleAxis(src.cols, dst.cols);
+  auto ay = resampleAxis(src.rows, dst.rows);
+  int taps = ay->taps;
+  bool verticalFirst = dst.rows <= src.rows;
+
+  forEachStripe(dst.rows, 0, dst.total(), [&](int begin, int end) {
+    std::vector<unsigned char const *> rows(taps);
+    cv::Mat tmp;
+    tmp.allocator = arenaAllocator();
+    if (verticalFirst) {
+      tmp.create(1, src.cols, src.type());
+      for (int y = begin; y < end; y++) {
+        for (int k = 0; k < taps; k++) {
+          rows[k] = src.ptr(ay->start[y] + k);
+        }
+        resampleColumns(rows.data(), &ay->weights[y * taps], taps, tmp.data,
+                        src.cols * src.elemSize());
+        resampleRow(tmp.data, dst.ptr(y), *ax);
+      }
+      return;
+    }
+
+    int first = ay->start[begin];
+    int last = ay->start[end - 1] + taps;
+    tmp.create(last - first, dst.cols, src.type());
+    for (int y = first; y < last; y++) {
+      resampleRow(src.ptr(y), tmp.ptr(y - first), *ax);
+    }
+    for (int y = begin; y < end; y++) {
+      for (int k = 0; k < taps; k++) {
+        rows[k] = tmp.ptr(ay->start[y] - first + k);
+      }
+      resampleColumns(rows.data(), &ay->weights[y * taps], taps, dst.ptr(y),
+                      dst.cols * dst.elemSize());
+    }
+  });
+}
+
+// 缩放百分比的上限
+constexpr int kMaxResamplePercent = 400;
+
+/**
+ * 按百分比缩放后的尺寸，每边至少1个像素
+ */
+static cv::Size resampledSize(cv::Size size, int percent) {
+  auto scale = [percent](int n) {
+    return std::max(1, static_cast<int>(std::lround(n * (percent / 100.0))));
+  };
+  return cv::Size(scale(size.width), scale(size.height));
+}
+
+/**
+ * 缩放
+ * @param src 输入图像
+ * @param percent 输出尺寸占输入的百分比 1-400，100为默认值(不改变)
  * @return 处理后的图像
  */
-cv::Mat adjustContrast(cv::Mat const &src, int value = 50) {
-  if (value == 50) {
+cv::Mat resample(cv::Mat const &src, int percent) {
+  CV_Assert(percent >= 1 && percent <= kMaxResamplePercent);
+  if (percent == 100) {
     return src.clone();
   }
 
   cv::Mat result;
-  // 将0-100映射到0.1-3.0的对比度系数
-  double alpha = value / 50.0;
-  if (alpha > 1.0) {
-    alpha = 1.0 + (alpha - 1.0) * 2.0; // 50-100映射到1.0-3.0
-  } else {
-    alpha = 0.1 + alpha * 0.9; // 0-50映射到0.1-1.0
-  }
-
-  src.convertTo(result, -1, alpha, 0);
+  resample(src, result, resampledSize(src.size(), percent));
   return result;
 }
 
 /**
- * 饱和度调整
+ * 对8位图像逐字节查表，允许 dst 与 src 为同一图像
  * @param src 输入图像
- * @param value 饱和度值 0-100，50为默认值(不改变)
+ * @param dst 输出图像
+ * @param lut 查找表
+ */
+static void applyLut(cv::Mat const &src, cv::Mat &dst, LutTable const &lut) {
+  dst.create(src.size(), src.type());
+  MYLIB_TIMED(Stat::lut, imageBytes(src) + imageBytes(dst));
+  size_t rowBytes = src.cols * src.elemSize();
+  bool continuous = src.isContinuous() && dst.isContinuous();
+  forEachStripe(src.rows, 0, src.total(), [&](int begin, int end) {
+    if (continuous) {
+      applyLut(src.ptr(begin), dst.ptr(begin), rowBytes * (end - begin), lut);
+      return;
+    }
+    for (int i = begin; i < end; i++) {
+      applyLut(src.ptr(i), dst.ptr(i), rowBytes, lut);
+    }
+  });
+}
+
+// 拷贝量超过该值(常见的末级缓存大小)时用非临时存储写目标图像
+constexpr size_t kStreamCopyBytes = size_t(8) << 20;
+
+/**
+ * 按条带并行拷贝图像，dst 已分配且尺寸类型一致时直接复用其内存
+ * @param src 输入图像
+ * @param dst 输出图像，不能与 src 重叠
+ */
+static void copyImage(cv::Mat const &src, cv::Mat &dst) {
+  dst.create(src.size(), src.type());
+  MYLIB_TIMED(Stat::copy, imageBytes(src) + imageBytes(dst));
+  size_t rowBytes = src.cols * src.elemSize();
+  bool stream = rowBytes * src.rows >= kStreamCopyBytes;
+  forEachStripe(src.rows, 0, src.total(), [&](int begin, int end) {
+    kernels().copyRows(src.ptr(begin), src.step, dst.ptr(begin), dst.step,
+                       rowBytes, end - begin, stream);
+  });
+}
+
+/**
+ * 对比度调整
+ * @param src 输入图像
+ * @param value 对比度值 0-100，50为默认值(不改变)
  * @return 处理后的图像
  */
-cv::Mat adjustSaturation(cv::Mat const &src, int value = 50) {
+cv::Mat adjustContrast(cv::Mat const &src, int value) {
   if (value == 50) {
     return src.clone();
   }
 
   cv::Mat result;
+  applyLut(src, result, *contrastLut(value));
+  return result;
+}
+
+// 当前使用的饱和度算法，见 set_saturation_mode
+static std::atomic<SaturationMode> gSaturationMode{SaturationMode::hsv};
+
+/**
+ * adjustSaturationHsv 对一个条带的处理
+ */
+static void adjustSaturationHsvStripe(cv::Mat const &src, cv::Mat &dst,
+                                      int value) {
+  // 中间图像都是临时的，从 arena 分配
   cv::Mat hsv;
+  cv::Mat channels[3];
+  hsv.allocator = arenaAllocator();
+  for (cv::Mat &c : channels) {
+    c.allocator = arenaAllocator();
+  }
 
   // 转换到HSV色彩空间
   cv::cvtColor(src, hsv, cv::COLOR_BGR2HSV);
 
   // 分离通道
-  std::vector<cv::Mat> channels;
   cv::split(hsv, channels);
 
   // 调整饱和度通道(S通道)
@@ -92,10 +344,64 @@ cv::Mat adjustSaturation(cv::Mat const &src, int value = 50) {
   channels[1].convertTo(channels[1], -1, saturation_factor, 0);
 
   // 合并通道
-  cv::merge(channels, hsv);
+  cv::merge(channels, 3, hsv);
 
   // 转换回BGR色彩空间
-  cv::cvtColor(hsv, result, cv::COLOR_HSV2BGR);
+  cv::cvtColor(hsv, dst, cv::COLOR_HSV2BGR);
+}
+
+/**
+ * 在HSV空间调整饱和度(原实现)，结果写入 dst (允许 dst 与 src 为同一图像)
+ * @param src 输入图像
+ * @param dst 输出图像
+ * @param value 饱和度值 0-100，不应为50
+ */
+static void adjustSaturationHsv(cv::Mat const &src, cv::Mat &dst, int value) {
+  dst.create(src.size(), src.type());
+  MYLIB_TIMED(Stat::saturationHsv, imageBytes(src) + imageBytes(dst));
+  forEachStripe(src.rows, 0, src.total(), [&](int begin, int end) {
+    cv::Mat out = dst.rowRange(begin, end);
+    adjustSaturationHsvStripe(src.rowRange(begin, end), out, value);
+  });
+}
+
+/**
+ * 饱和度调整，结果写入 dst (允许 dst 与 src 为同一图像)
+ * 除 hsv 模式外都在RGB空间一次遍历完成，不产生临时图像
+ * @param src 输入图像
+ * @param dst 输出图像
+ * @param value 饱和度值 0-100，不应为50
+ */
+static void adjustSaturation(cv::Mat const &src, cv::Mat &dst, int value) {
+  SaturationMode mode = gSaturationMode.load(std::memory_order_relaxed);
+  if (mode == SaturationMode::hsv) {
+    adjustSaturationHsv(src, dst, value);
+    return;
+  }
+
+  dst.create(src.size(), src.type());
+  MYLIB_TIMED(Stat::saturationRgb, imageBytes(src) + imageBytes(dst));
+  float factor = saturationFactor(value);
+  forEachStripe(src.rows, 0, src.total(), [&](int begin, int end) {
+    for (int i = begin; i < end; i++) {
+      saturateRow(src.ptr(i), dst.ptr(i), src.cols, factor, mode);
+    }
+  });
+}
+
+/**
+ * 饱和度调整
+ * @param src 输入图像
+ * @param value 饱和度值 0-100，50为默认值(不改变)
+ * @return 处理后的图像
+ */
+cv::Mat adjustSaturation(cv::Mat const &src, int value) {
+  if (value == 50) {
+    return src.clone();
+  }
+
+  cv::Mat result;
+  adjustSaturation(src, result, value);
   return result;
 }
 
@@ -105,44 +411,1123 @@ cv::Mat adjustSaturation(cv::Mat const &src, int value = 50) {
  * @param value 亮度值 0-100，50为默认值(不改变)
  * @return 处理后的图像
  */
-cv::Mat adjustBrightness(cv::Mat const &src, int value = 50) {
+cv::Mat adjustBrightness(cv::Mat const &src, int value) {
   if (value == 50) {
     return src.clone();
   }
 
   cv::Mat result;
-  // 将0-100映射到-100到+100的亮度偏移
-  double beta = (value - 50) * 2.0; // -100到+100
+  applyLut(src, result, *brightnessLut(value));
+  return result;
+}
+
+/**
+ * 自动色阶两端裁剪的百分比，见 set_auto_levels_clip
+ */
+struct levelsClip {
+  float low;
+  float high;
+
+  bool operator==(levelsClip const &) const = default;
+};
+
+static std::atomic<levelsClip> gLevelsClip{levelsClip{0.1f, 0.1f}};
+
+/**
+ * 统计三通道图像各通道的直方图，按条带并行：每个条带先统计到自己的
+ * 局部直方图，最后在锁内合并
+ */
+static ChannelHistogram channelHistogram(cv::Mat const &src) {
+  MYLIB_TIMED(Stat::histogram, imageBytes(src));
+  ChannelHistogram hist{};
+  std::mutex mutex;
+  forEachStripe(src.rows, 0, src.total(), [&](int begin, int end) {
+    ChannelHistogram part{};
+    accumulateHistogram(src.ptr(begin), src.step, src.cols, end - begin,
+                        part);
+    std::lock_guard<std::mutex> lock(mutex);
+    hist += part;
+  });
+  return hist;
+}
+
+/**
+ * 自动色阶，结果写入 dst (允许 dst 与 src 为同一图像)
+ * 色阶由 pre 映射后图像的直方图决定，直方图经查找表映射即可得到，不必
+ * 先生成中间图像；pre、post 与色阶复合为每个通道一张表，整图只查表一次
+ * @param value 强度 0-100，不应为0
+ * @param pre 紧挨在该步骤之前的对比度/亮度查找表，可以为空
+ * @param post 紧挨在该步骤之后的对比度/亮度查找表，可以为空
+ * @param hist src 的直方图(如会话缓存的源图像直方图)，为空时现场统计
+ */
+static void autoLevels(cv::Mat const &src, cv::Mat &dst, int value,
+                       LutTable const *pre, LutTable const *post,
+                       ChannelHistogram const *hist = nullptr) {
+  ChannelHistogram counted;
+  if (hist == nullptr) {
+    counted = channelHistogram(src);
+    hist = &counted;
+  }
+  if (pre != nullptr) {
+    counted = remapHistogram(*hist, *pre);
+    hist = &counted;
+  }
+  levelsClip clip = gLevelsClip.load(std::memory_order_relaxed);
+  ChannelLut lut;
+  autoLevelsLut(*hist, value, clip.low, clip.high, lut);
+  for (LutTable &t : lut.channels) {
+    LutTable levels = t;
+    for (int k = 0; k < 256; k++) {
+      unsigned char v = levels.data[pre == nullptr ? k : pre->data[k]];
+      t.data[k] = post == nullptr ? v : post->data[v];
+    }
+  }
+
+  dst.create(src.size(), src.type());
+  MYLIB_TIMED(Stat::autoLevels, imageBytes(src) + imageBytes(dst));
+  forEachStripe(src.rows, 0, src.total(), [&](int begin, int end) {
+    for (int i = begin; i < end; i++) {
+      applyChannelLut(src.ptr(i), dst.ptr(i), src.cols, lut);
+    }
+  });
+}
+
+/**
+ * 自动色阶
+ * @param src 输入图像
+ * @param value 强度 0-100，0为默认值(不改变)
+ * @return 处理后的图像
+ */
+cv::Mat autoLevels(cv::Mat const &src, int value) {
+  if (value == 0) {
+    return src.clone();
+  }
 
-  src.convertTo(result, -1, 1.0, beta);
+  cv::Mat result;
+  autoLevels(src, result, value, nullptr, nullptr);
   return result;
 }
 
+/**
+ * param.type 的取值个数
+ */
+constexpr int kParamTypes = 7;
+
+/**
+ * 不改变图像的 value：手动调整为50，自动色阶和降噪为0，缩放为100
+ */
+static int identityValue(int type) {
+  switch (type) {
+  case 4:
+  case 5:
+    return 0;
+  case 6:
+    return 100;
+  default:
+    return 50;
+  }
+}
+
+/**
+ * value 是否在 type 的取值范围内：缩放为 1-400，其余为 0-100
+ * 查找表缓存和定点锐化的强度都依赖这一范围
+ */
+static bool validValue(int type, int value) {
+  return type == 6 ? value >= 1 && value <= kMaxResamplePercent
+                   : value >= 0 && value <= 100;
+}
+
+/**
+ * 是否读取邻域像素(不能原地执行)；缩放还会改变图像尺寸
+ */
+static bool isNeighborhoodOp(int type) {
+  return type == 0 || type == 5 || type == 6;
+}
+
+/**
+ * 是否为逐像素、逐通道独立的映射(可合并为一张查找表)
+ */
+static bool isPointOp(int type) { return type == 1 || type == 3; }
+
+/**
+ * 获取一组相邻对比度/亮度步骤的复合查找表
+ * 单步和“对比度+亮度”直接取缓存，更长的组合由缓存的单步表复合而成
+ */
+static std::shared_ptr<LutTable const>
+pointOpsLut(std::vector<param> const &ops) {
+  auto single = [](param p) {
+    return p.type == 1 ? contrastLut(p.value) : brightnessLut(p.value);
+  };
+  if (ops.size() == 1) {
+    return single(ops[0]);
+  }
+  if (ops.size() == 2 && ops[0].type == 1 && ops[1].type == 3) {
+    return contrastBrightnessLut(ops[0].value, ops[1].value);
+  }
+
+  // lut ∘ prev: 每一步的饱和截断都保留在表中，结果与逐步执行一致
+  auto table = std::make_shared<LutTable>(*single(ops[0]));
+  for (size_t i = 1; i < ops.size(); i++) {
+    auto next = single(ops[i]);
+    for (int k = 0; k < 256; k++) {
+      table->data[k] = next->data[table->data[k]];
+    }
+  }
+  return table;
+}
+
+/**
+ * 执行计划中的一步；相邻的对比度/亮度步骤已合并为 lut
+ * 自动色阶(type 4)的 lut、post 为紧挨在它之前、之后的对比度/亮度步骤，
+ * 执行时与色阶复合，可以为空
+ */
+struct step {
+  int type;
+  int value;
+  std::shared_ptr<LutTable const> lut;
+  bool fixedPoint{false}; // 锐化使用定点实现，见 PARAM_FIXED_POINT
+  std::shared_ptr<LutTable const> post{};
+};
+
+/**
+ * 校验参数并生成执行计划: 跳过恒等步骤，相邻的对比度/亮度步骤复合为一张
+ * 查找表，与自动色阶相邻时并入色阶步骤
+ * @return false 表示存在无效的 type 或超出范围的 value
+ */
+static bool planChain(param const *params, int count,
+                      std::vector<step> &steps) {
+  if (count < 0 || (count > 0 && params == nullptr)) {
+    return false;
+  }
+
+  std::vector<param> group;
+  auto flush = [&]() {
+    if (group.empty()) {
+      return;
+    }
+    if (!steps.empty() && steps.back().type == 4) {
+      steps.back().post = pointOpsLut(group);
+    } else {
+      steps.push_back(step{1, 0, pointOpsLut(group)});
+    }
+    group.clear();
+  };
+  for (int i = 0; i < count; i++) {
+    param p = params[i];
+    bool fixedPoint = (p.type & PARAM_FIXED_POINT) != 0;
+    p.type &= ~PARAM_FIXED_POINT;
+    if (p.type < 0 || p.type >= kParamTypes || !validValue(p.type, p.value)) {
+      return false;
+    }
+    if (p.value == identityValue(p.type)) {
+      continue;
+    }
+    if (isPointOp(p.type)) {
+      group.push_back(p);
+    } else if (p.type == 4) {
+      std::shared_ptr<LutTable const> pre;
+      if (!group.empty()) {
+        pre = pointOpsLut(group);
+        group.clear();
+      }
+      steps.push_back(step{4, p.value, pre});
+    } else {
+      flush();
+      steps.push_back(step{p.type, p.value, nullptr, fixedPoint});
+    }
+  }
+  flush();
+  return true;
+}
+
+/**
+ * 一步的输出尺寸
+ */
+static cv::Size stepSize(step const &s, cv::Size size) {
+  return s.type == 6 ? resampledSize(size, s.value) : size;
+}
+
+/**
+ * 执行计划后的输出尺寸
+ */
+static cv::Size chainSize(std::vector<step> const &steps, cv::Size size) {
+  for (step const &s : steps) {
+    size = stepSize(s, size);
+  }
+  return size;
+}
+
+/**
+ * 按计划处理 img，结果写入 out
+ * out 的尺寸为 chainSize 的结果；out 可以与 img 是同一块内存(原地处理)，
+ * 除此之外两者不能重叠
+ */
+static void runChain(std::vector<step> const &steps, cv::Mat const &img,
+                     cv::Mat &out) {
+  MYLIB_TIMED(Stat::chain, imageBytes(img) + imageBytes(out));
+  if (steps.empty()) {
+    if (out.data != img.data) {
+      copyImage(img, out);
+    }
+    return;
+  }
+
+  // 最后一步直接写入 out；中间结果在两张临时图之间轮换，
+  // 逐像素步骤在已有的临时图上原地执行，原地调用时也可直接改写输入
+  bool inplace = out.data == img.data;
+  cv::Mat tmp[2];
+  tmp[0].allocator = arenaAllocator();
+  tmp[1].allocator = arenaAllocator();
+  int next = 0;
+  cv::Mat cur = img;
+  for (size_t i = 0; i < steps.size(); i++) {
+    step const &s = steps[i];
+    cv::Size size = stepSize(s, cur.size());
+    cv::Mat dst;
+    if (i + 1 == steps.size()) {
+      dst = out;
+    } else if (!isNeighborhoodOp(s.type) &&
+               (inplace || cur.data != img.data)) {
+      dst = cur;
+    } else {
+      tmp[next].create(size, img.type());
+      dst = tmp[next];
+      next ^= 1;
+    }
+
+    if (isNeighborhoodOp(s.type)) {
+      auto filter = [&s, size](cv::Mat const &src, cv::Mat &out) {
+        if (s.type == 0) {
+          sharpen(src, out, s.value, 1.0f, s.fixedPoint);
+        } else if (s.type == 5) {
+          denoise(src, out, s.value);
+        } else {
+          resample(src, out, size);
+        }
+      };
+      if (dst.data == cur.data) {
+        // 原地调用时最后一步的锐化、降噪、缩放不能读写同一块内存
+        cv::Mat res;
+        res.allocator = arenaAllocator();
+        filter(cur, res);
+        copyImage(res, dst);
+      } else {
+        filter(cur, dst);
+      }
+    } else if (s.type == 2) {
+      adjustSaturation(cur, dst, s.value);
+    } else if (s.type == 4) {
+      autoLevels(cur, dst, s.value, s.lut.get(), s.post.get());
+    } else {
+      applyLut(cur, dst, *s.lut);
+    }
+    cur = dst;
+  }
+}
+
+/**
+ * 从缓冲池分配输出并执行计划，供返回新缓冲区的接口使用
+ */
+static int runChainPooled(std::vector<step> const &steps,
+                          unsigned char *input_rgb, int width, int height,
+                          int stride, int *output_width, int *output_hight,
+                          int *output_stride, unsigned char **output_rgb) {
+  // 尺寸不变时沿用输入的步长，缩放后每行按64字节对齐
+  cv::Size size = chainSize(steps, cv::Size(width, height));
+  int outStride = size == cv::Size(width, height)
+                      ? stride
+                      : (size.width * 3 + 63) & ~63;
+  unsigned char *buf =
+      acquireBuffer(static_cast<size_t>(size.height) * outStride);
+  if (buf == nullptr) {
+    return -1;
+  }
+  *output_width = size.width;
+  *output_hight = size.height;
+  *output_stride = outStride;
+  *output_rgb = buf;
+
+  cv::Mat img(height, width, CV_8UC3, input_rgb, stride);
+  cv::Mat out(size, CV_8UC3, buf, outStride);
+  runChain(steps, img, out);
+  return 0;
+}
 
 void processrgb(param p, unsigned char *input_rgb, int width, int height,
                 int stride, int *output_width, int *output_hight,
                 int *output_stride, unsigned char **output_rgb) {
-  *output_width = width;
-  *output_hight = height;
-  *output_stride = stride;
+  *output_rgb = nullptr;
+  std::vector<step> steps;
+  if (!planChain(&p, 1, steps)) {
+    return;
+  }
+  runChainPooled(steps, input_rgb, width, height, stride, output_width,
+                 output_hight, output_stride, output_rgb);
+}
+
+int processrgb_chain(param const *params, int count, unsigned char *input_rgb,
+                     int width, int height, int stride, int *output_width,
+                     int *output_hight, int *output_stride,
+                     unsigned char **output_rgb) {
+  *output_rgb = nullptr;
+  std::vector<step> steps;
+  if (!planChain(params, count, steps)) {
+    return -1;
+  }
+  return runChainPooled(steps, input_rgb, width, height, stride, output_width,
+                        output_hight, output_stride, output_rgb);
+}
+
+int processrgb_chain_into(param const *params, int count,
+                          unsigned char *input_rgb, int width, int height,
+                          int stride, unsigned char *output_rgb,
+                          int output_width, int output_height,
+                          int output_stride) {
+  if (input_rgb == nullptr || output_rgb == nullptr || width <= 0 ||
+      height <= 0 || stride < width * 3) {
+    return -1;
+  }
+  std::vector<step> steps;
+  if (!planChain(params, count, steps)) {
+    return -1;
+  }
+  // 缓冲区由调用方按其尺寸分配，与计划的输出尺寸不符时拒绝，避免越界写入
+  cv::Size size = chainSize(steps, cv::Size(width, height));
+  if (size != cv::Size(output_width, output_height) ||
+      output_stride < size.width * 3) {
+    return -1;
+  }
+
   cv::Mat img(height, width, CV_8UC3, input_rgb, stride);
-  cv::Mat res;
-
-  if (p.type == 0) {
-    res = sharpen(img, p.value);
-  } else if (p.type == 1) {
-    res = adjustContrast(img, p.value);
-  } else if (p.type == 2) {
-    res = adjustSaturation(img, p.value);
-  } else if (p.type == 3) {
-    res = adjustBrightness(img, p.value);
-  } else {
+  cv::Mat out(size, CV_8UC3, output_rgb, output_stride);
+  runChain(steps, img, out);
+  return 0;
+}
+
+int processrgb_chain_size(param const *params, int count, int width,
+                          int height, int *output_width, int *output_hight) {
+  std::vector<step> steps;
+  if (width <= 0 || height <= 0 || !planChain(params, count, steps)) {
+    return -1;
+  }
+  cv::Size size = chainSize(steps, cv::Size(width, height));
+  *output_width = size.width;
+  *output_hight = size.height;
+  return 0;
+}
+
+int processrgb_into(param p, unsigned char *input_rgb, int width, int height,
+                    int stride, unsigned char *output_rgb, int output_width,
+                    int output_height, int output_stride) {
+  return processrgb_chain_into(&p, 1, input_rgb, width, height, stride,
+                               output_rgb, output_width, output_height,
+                               output_stride);
+}
+
+void release_rgb(unsigned char *output_rgb) { releaseBuffer(output_rgb); }
+
+int set_saturation_mode(int mode) {
+  if (mode < 0 || mode > 2) {
+    return -1;
+  }
+  gSaturationMode.store(static_cast<SaturationMode>(mode));
+  return 0;
+}
+
+int set_auto_levels_clip(float low_percent, float high_percent) {
+  if (!(low_percent >= 0 && high_percent >= 0 &&
+        low_percent + high_percent < 100)) {
+    return -1;
+  }
+  gLevelsClip.store(levelsClip{low_percent, high_percent});
+  return 0;
+}
+
+void set_num_threads(int num_threads) {
+  setPoolThreads(num_threads);
+  // 条带已经占满所有线程，关闭 OpenCV 内部的并行以免嵌套造成超额订阅
+  cv::setNumThreads(poolThreads() > 1 ? 1 : -1);
+}
+
+int get_num_threads() { return poolThreads(); }
+
+int get_cpu_level() { return static_cast<int>(kernels().level); }
+
+void get_arena_stats(arena_stats *stats) {
+  arenaCounters c = arenaStats();
+  stats->peak_bytes = c.peakBytes;
+  stats->reserved_bytes = c.reservedBytes;
+  stats->fallbacks = c.fallbacks;
+}
+
+void reset_arena_stats() { resetArenaStats(); }
+
+int get_op_stats(op_stats *stats, int capacity) {
+#ifdef MYLIB_ENABLE_STATS
+  statTotals totals[kStatCount];
+  readStats(totals);
+  int count = std::min(std::max(capacity, 0), kStatCount);
+  for (int i = 0; i < count; i++) {
+    statTotals const &t = totals[i];
+    stats[i] = op_stats{statName(static_cast<Stat>(i)), t.calls, t.totalNs,
+                        t.maxNs, t.bytes};
+  }
+  return kStatCount;
+#else
+  (void)stats;
+  (void)capacity;
+  return 0;
+#endif
+}
+
+void reset_op_stats() { resetStats(); }
+
+// 会话中各阶段依次执行的 type；自动色阶最先执行，它的输入总是源图像，
+// 直方图在会话中只统计一次；降噪在锐化之前，避免放大噪声
+constexpr int kStageTypes[] = {4, 5, 0, 1, 2, 3};
+constexpr int kStageCount = std::size(kStageTypes);
+
+/**
+ * 执行 type 的阶段，不在会话中的 type 为-1
+ */
+static int stageOf(int type) {
+  for (int i = 0; i < kStageCount; i++) {
+    if (kStageTypes[i] == type) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// 预览金字塔最小一层的边长下限
+constexpr int kPyramidMinSize = 32;
+
+/**
+ * 执行会话中的一个阶段
+ * @param value 不应为恒等值
+ * @param dst 不能与 src 共享内存；已分配且尺寸类型一致时直接复用其内存
+ * @param scale src 相对原图的缩放比例，见 sharpen
+ * @param hist 自动色阶使用的直方图
+ */
+static void runStage(int type, int value, cv::Mat const &src, cv::Mat &dst,
+                     float scale, ChannelHistogram const *hist) {
+  switch (type) {
+  case 0:
+    sharpen(src, dst, value, scale);
+    break;
+  case 1:
+    applyLut(src, dst, *contrastLut(value));
+    break;
+  case 2:
+    adjustSaturation(src, dst, value);
+    break;
+  case 4:
+    autoLevels(src, dst, value, nullptr, nullptr, hist);
+    break;
+  case 5:
+    denoise(src, dst, value, scale);
+    break;
+  default:
+    applyLut(src, dst, *brightnessLut(value));
+    break;
+  }
+}
+
+/**
+ * 一种分辨率下各阶段的缓存
+ * 阶段 i 的输出只取决于输入图像和阶段 0..i 的参数；恒等阶段直接引用上一
+ * 阶段的图像，不占额外内存；失效的阶段保留自己的缓冲区，重算时原地复用，
+ * 避免每次拖动滑块都重新分配整幅图像
+ */
+struct stageCache {
+  struct stage {
+    cv::Mat image;
+    bool valid{false};
+    bool owned{false}; // image 是否为本阶段独占的缓冲区
+  };
+
+  cv::Mat source; // 输入图像，内存由会话统计
+  stage stages[kStageCount];
+  SaturationMode saturationMode{SaturationMode::hsv};
+  levelsClip clip{gLevelsClip.load(std::memory_order_relaxed)};
+
+  /**
+   * 更换输入图像并丢弃全部缓存
+   */
+  void reset(cv::Mat const &img) {
+    source = img;
+    for (stage &s : stages) {
+      s = stage{};
+    }
+  }
+
+  /**
+   * 使阶段 from 及之后的结果失效
+   */
+  void invalidate(int from) {
+    for (int i = from; i < kStageCount; i++) {
+      stages[i].valid = false;
+      if (!stages[i].owned) {
+        stages[i].image.release();
+      }
+    }
+  }
+
+  /**
+   * 按缓冲区去重后各阶段的内存占用，不含输入图像
+   */
+  size_t memoryUsage() const {
+    size_t total = 0;
+    unsigned char const *seen[kStageCount];
+    int count = 0;
+    for (stage const &s : stages) {
+      unsigned char const *data = s.image.data;
+      if (data == nullptr || data == source.data ||
+          std::find(seen, seen + count, data) != seen + count) {
+        continue;
+      }
+      seen[count++] = data;
+      total += imageBytes(s.image);
+    }
+    return total;
+  }
+
+  /**
+   * 释放一个阶段的缓冲区，引用同一缓冲区的其他阶段一起失效
+   * 输入图像和最终结果所在的缓冲区不会被释放
+   */
+  void evict(int i) {
+    unsigned char const *data = stages[i].image.data;
+    if (data == nullptr || data == source.data || data == result().data) {
+      return;
+    }
+    for (stage &s : stages) {
+      if (s.image.data == data) {
+        s.image.release();
+        s.valid = false;
+        s.owned = false;
+      }
+    }
+  }
+
+  /**
+   * 内存不足时的丢弃顺序：失效阶段保留的缓冲区、最近修改阶段之后的中间
+   * 结果(下次修改时本来就要重算)、离修改点较远的更早结果，最后才是最近
+   * 修改阶段的输入
+   */
+  int evictionOrder(int lastEdited, int *order) const {
+    int count = 0;
+    for (int i = 0; i < kStageCount; i++) {
+      if (!stages[i].valid) {
+        order[count++] = i;
+      }
+    }
+    for (int i = lastEdited; i < kStageCount - 1; i++) {
+      order[count++] = i;
+    }
+    for (int i = 0; i < lastEdited; i++) {
+      order[count++] = i;
+    }
+    return count;
+  }
+
+  /**
+   * @param hist 源图像的直方图，自动色阶阶段为恒等时可以为空
+   */
+  void render(int const *values, float scale, ChannelHistogram const *hist) {
+    SaturationMode mode = gSaturationMode.load(std::memory_order_relaxed);
+    if (mode != saturationMode) {
+      saturationMode = mode;
+      invalidate(stageOf(2));
+    }
+    levelsClip levels = gLevelsClip.load(std::memory_order_relaxed);
+    if (levels != clip) {
+      clip = levels;
+      invalidate(stageOf(4));
+    }
+
+    int first = 0;
+    cv::Mat cur = source;
+    for (int i = kStageCount - 1; i >= 0; i--) {
+      if (stages[i].valid) {
+        first = i + 1;
+        cur = stages[i].image;
+        break;
+      }
+    }
+
+    for (int i = first; i < kStageCount; i++) {
+      stage &s = stages[i];
+      int type = kStageTypes[i];
+      if (values[i] == identityValue(type)) {
+        s.image = cur;
+        s.owned = false;
+      } else {
+        if (!s.owned) {
+          s.image.release();
+        }
+        runStage(type, values[i], cur, s.image, scale, hist);
+        s.owned = true;
+      }
+      s.valid = true;
+      cur = s.image;
+    }
+  }
+
+  cv::Mat const &result() const { return stages[kStageCount - 1].image; }
+};
+
+struct edit_session {
+  int values[kStageCount]{0, 0, 50, 50, 50, 50}; // 按阶段顺序，均为恒等值
+  int lastEdited{0}; // 最近一次修改的阶段，内存不足时优先保留它的输入
+  size_t memoryLimit{0};
+  // 源图像的直方图，第一次使用自动色阶时统计；预览也使用它，
+  // 使预览与最终结果的色阶相同
+  std::unique_ptr<ChannelHistogram> histogram;
+
+  // pyramid[0] 为源图像的拷贝，之后每层用 pyrDown 缩小一半，按需生成
+  std::vector<cv::Mat> pyramid;
+  stageCache full;
+  stageCache preview;
+  int previewLevel{0}; // preview 当前所在的金字塔层，0 表示未使用
+
+  size_t memoryUsage() const {
+    size_t total = full.memoryUsage() + preview.memoryUsage();
+    for (cv::Mat const &level : pyramid) {
+      total += imageBytes(level);
+    }
+    return total;
+  }
+
+  /**
+   * 超出内存上限时先丢弃原图分辨率的中间结果(只在最终渲染时使用)，
+   * 再丢弃预览的中间结果；金字塔和两者的最终结果总会保留
+   */
+  void trim() {
+    if (memoryLimit == 0) {
+      return;
+    }
+    for (stageCache *cache : {&full, &preview}) {
+      int order[kStageCount * 2];
+      int count = cache->evictionOrder(lastEdited, order);
+      for (int k = 0; k < count && memoryUsage() > memoryLimit; k++) {
+        cache->evict(order[k]);
+      }
+    }
+  }
+
+  /**
+   * 自动色阶使用的直方图，该阶段为恒等时为空
+   */
+  ChannelHistogram const *levelsHistogram() {
+    if (values[stageOf(4)] == identityValue(4)) {
+      return nullptr;
+    }
+    if (histogram == nullptr) {
+      histogram =
+          std::make_unique<ChannelHistogram>(channelHistogram(pyramid[0]));
+    }
+    return histogram.get();
+  }
+
+  /**
+   * 不小于视口的最小金字塔层，缺少的层在这里生成
+   */
+  int previewLevelFor(int width, int height) {
+    int level = 0;
+    while (true) {
+      cv::Mat const &cur = pyramid[level];
+      int w = (cur.cols + 1) / 2;
+      int h = (cur.rows + 1) / 2;
+      if (w < width || h < height || w < kPyramidMinSize ||
+          h < kPyramidMinSize) {
+        return level;
+      }
+      level++;
+      if (level == static_cast<int>(pyramid.size())) {
+        cv::Mat next;
+        cv::pyrDown(cur, next, cv::Size(w, h));
+        pyramid.push_back(next);
+      }
+    }
+  }
+};
+
+edit_session *create_session(unsigned char const *input_rgb, int width,
+                             int height, int stride, size_t memory_limit) {
+  if (input_rgb == nullptr || width <= 0 || height <= 0 ||
+      stride < width * 3) {
+    return nullptr;
+  }
+  auto *session = new edit_session;
+  cv::Mat img(height, width, CV_8UC3, const_cast<unsigned char *>(input_rgb),
+              stride);
+  session->pyramid.push_back(img.clone());
+  session->full.reset(session->pyramid[0]);
+  session->full.saturationMode =
+      gSaturationMode.load(std::memory_order_relaxed);
+  session->memoryLimit = memory_limit;
+  return session;
+}
+
+int session_set_param(edit_session *session, param p) {
+  int stage = stageOf(p.type);
+  if (session == nullptr || stage < 0 || !validValue(p.type, p.value)) {
+    return -1;
+  }
+  if (session->values[stage] != p.value) {
+    session->values[stage] = p.value;
+    session->lastEdited = stage;
+    session->full.invalidate(stage);
+    session->preview.invalidate(stage);
+  }
+  return 0;
+}
+
+/**
+ * 输出 cache 的最终结果
+ */
+static void sessionOutput(stageCache const &cache, int *output_width,
+                          int *output_hight, int *output_stride,
+                          unsigned char const **output_rgb) {
+  cv::Mat const &out = cache.result();
+  *output_width = out.cols;
+  *output_hight = out.rows;
+  *output_stride = static_cast<int>(out.step[0]);
+  *output_rgb = out.data;
+}
+
+int session_render(edit_session *session, int *output_width,
+                   int *output_hight, int *output_stride,
+                   unsigned char const **output_rgb) {
+  if (session == nullptr) {
+    return -1;
+  }
+  session->full.render(session->values, 1.0f, session->levelsHistogram());
+  session->trim();
+  sessionOutput(session->full, output_width, output_hight, output_stride,
+                output_rgb);
+  return 0;
+}
+
+int session_render_preview(edit_session *session, int viewport_width,
+                           int viewport_height, int *output_width,
+                           int *output_hight, int *output_stride,
+                           unsigned char const **output_rgb) {
+  if (session == nullptr || viewport_width <= 0 || viewport_height <= 0) {
+    return -1;
+  }
+  int level = session->previewLevelFor(viewport_width, viewport_height);
+  if (level == 0) {
+    // 视口不小于原图时预览就是最终结果
+    return session_render(session, output_width, output_hight,
+                          output_stride, output_rgb);
+  }
+
+  stageCache &preview = session->preview;
+  if (level != session->previewLevel) {
+    preview.reset(session->pyramid[level]);
+    preview.saturationMode = gSaturationMode.load(std::memory_order_relaxed);
+    session->previewLevel = level;
+  }
+  preview.render(session->values, std::ldexp(1.0f, -level),
+                 session->levelsHistogram());
+  session->trim();
+  sessionOutput(preview, output_width, output_hight, output_stride,
+                output_rgb);
+  return 0;
+}
+
+size_t session_memory_usage(edit_session const *session) {
+  return session == nullptr ? 0 : session->memoryUsage();
+}
+
+void destroy_session(edit_session *session) { delete session; }
+
+/**
+ * 环形队列中的一个槽位，序号为 seq 的帧占用 seq % ring_size
+ * 处于 running 状态时只由处理它的线程访问，其余状态在流的互斥锁下访问
+ */
+struct streamSlot {
+  enum class state { free, queued, running, done };
+
+  state status{state::free};
+  unsigned char *input{nullptr};
+  unsigned char *output{nullptr};
+  int outputStride{0};
+  bool pooled{false}; // output 由缓冲池分配
+  void *userData{nullptr};
+  std::shared_ptr<std::vector<step> const> plan;
+  std::chrono::steady_clock::time_point submitted;
+  int result{0};
+  double latencyMs{0};
+};
+
+/**
+ * 计划是否保持图像尺寸；帧流的输出与输入尺寸相同，不接受缩放
+ */
+static bool keepsSize(std::vector<step> const &steps) {
+  return std::none_of(steps.begin(), steps.end(),
+                      [](step const &s) { return s.type == 6; });
+}
+
+/**
+ * 按 timeout_ms 的约定(0不等待，负数一直等待)等待 pred 成立
+ */
+template <typename Pred>
+static bool waitFor(std::condition_variable &cv,
+                    std::unique_lock<std::mutex> &lock, int timeout_ms,
+                    Pred pred) {
+  if (timeout_ms < 0) {
+    cv.wait(lock, pred);
+    return true;
+  }
+  return cv.wait_for(lock, std::chrono::milliseconds(timeout_ms), pred);
+}
+
+struct frame_stream {
+  int width{0};
+  int height{0};
+  int stride{0};
+  stream_callback callback{nullptr};
+  void *context{nullptr};
+  std::vector<streamSlot> ring;
+  std::shared_ptr<std::vector<step> const> plan; // 之后提交的帧使用的计划
+
+  // 已交付 < nextDeliver <= 处理中/已完成 < nextRun <= 排队 < nextSubmit
+  unsigned long long nextSubmit{0};
+  unsigned long long nextRun{0};
+  unsigned long long nextDeliver{0};
+  bool delivering{false}; // 有处理线程正在按序调用回调
+  bool stopping{false};
+
+  std::mutex mutex;
+  std::condition_variable queued;    // 有新帧或正在关闭
+  std::condition_variable completed; // 有帧完成或交付
+  std::condition_variable space;     // 有槽位空出
+  std::vector<std::thread> workers;
+
+  streamSlot &slot(unsigned long long seq) { return ring[seq % ring.size()]; }
+
+  bool full() const { return nextSubmit - nextDeliver >= ring.size(); }
+
+  bool nextDone() {
+    return nextDeliver < nextSubmit &&
+           slot(nextDeliver).status == streamSlot::state::done;
+  }
+
+  stream_frame frameOf(unsigned long long seq) {
+    streamSlot &s = slot(seq);
+    return stream_frame{seq,      s.result,       s.input,
+                        s.output, s.outputStride, s.userData,
+                        s.latencyMs};
+  }
+
+  /**
+   * 交付序号最小的帧之后空出它的槽位
+   */
+  void retire() {
+    slot(nextDeliver) = streamSlot{};
+    nextDeliver++;
+    space.notify_one();
+  }
+
+  /**
+   * 处理一帧，调用时不持有锁
+   */
+  void process(streamSlot &s) {
+    s.result = 0;
+    if (s.output == nullptr) {
+      s.output = acquireBuffer(static_cast<size_t>(height) * stride);
+      s.outputStride = stride;
+      s.pooled = s.output != nullptr;
+    }
+    if (s.output == nullptr) {
+      s.result = -1;
+    } else {
+      cv::Mat img(height, width, CV_8UC3, s.input, stride);
+      cv::Mat out(height, width, CV_8UC3, s.output, s.outputStride);
+      runChain(*s.plan, img, out);
+    }
+    s.latencyMs = std::chrono::duration<double, std::milli>(
+                      std::chrono::steady_clock::now() - s.submitted)
+                      .count();
+  }
+
+  /**
+   * 按序调用回调，直到下一帧尚未完成；已有线程在交付时由它接着交付
+   */
+  void deliver(std::unique_lock<std::mutex> &lock) {
+    if (delivering) {
+      return;
+    }
+    delivering = true;
+    while (nextDone()) {
+      stream_frame frame = frameOf(nextDeliver);
+      lock.unlock();
+      callback(context, &frame);
+      lock.lock();
+      retire();
+    }
+    delivering = false;
+    completed.notify_all();
+  }
+
+  /**
+   * 处理线程：按序号领取排队的帧；关闭时处理完剩余的帧再退出
+   */
+  void workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      queued.wait(lock, [this] { return stopping || nextRun < nextSubmit; });
+      if (nextRun == nextSubmit) {
+        return;
+      }
+      streamSlot &s = slot(nextRun++);
+      s.status = streamSlot::state::running;
+      lock.unlock();
+      process(s);
+      lock.lock();
+      s.status = streamSlot::state::done;
+      if (callback != nullptr) {
+        deliver(lock);
+      } else {
+        completed.notify_all();
+      }
+    }
+  }
+
+  /**
+   * 已提交的帧是否全部处理完成(设置了回调时还要求全部交付)
+   */
+  bool drained() {
+    if (callback != nullptr) {
+      return nextDeliver == nextSubmit;
+    }
+    for (unsigned long long seq = nextDeliver; seq < nextSubmit; seq++) {
+      if (slot(seq).status != streamSlot::state::done) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+frame_stream *create_stream(param const *params, int count,
+                            stream_options const *options) {
+  if (options == nullptr || options->width <= 0 || options->height <= 0 ||
+      options->stride < options->width * 3 || options->ring_size <= 0) {
+    return nullptr;
+  }
+  auto plan = std::make_shared<std::vector<step>>();
+  if (!planChain(params, count, *plan) || !keepsSize(*plan)) {
+    return nullptr;
+  }
+
+  auto *stream = new frame_stream;
+  stream->width = options->width;
+  stream->height = options->height;
+  stream->stride = options->stride;
+  stream->callback = options->callback;
+  stream->context = options->context;
+  stream->ring.resize(options->ring_size);
+  stream->plan = std::move(plan);
+
+  int workers = options->workers;
+  if (workers <= 0) {
+    workers = static_cast<int>(std::thread::hardware_concurrency());
+  }
+  workers = std::clamp(workers, 1, options->ring_size);
+  for (int i = 0; i < workers; i++) {
+    stream->workers.emplace_back([stream] { stream->workerLoop(); });
+  }
+  return stream;
+}
+
+int stream_set_params(frame_stream *stream, param const *params, int count) {
+  auto plan = std::make_shared<std::vector<step>>();
+  if (stream == nullptr || !planChain(params, count, *plan) ||
+      !keepsSize(*plan)) {
+    return -1;
+  }
+  std::lock_guard<std::mutex> lock(stream->mutex);
+  stream->plan = std::move(plan);
+  return 0;
+}
+
+int stream_submit(frame_stream *stream, unsigned char *input_rgb,
+                  unsigned char *output_rgb, int output_stride,
+                  void *user_data, int timeout_ms,
+                  unsigned long long *sequence) {
+  if (stream == nullptr || input_rgb == nullptr ||
+      (output_rgb != nullptr && output_stride < stream->width * 3)) {
+    return -1;
+  }
+
+  std::unique_lock<std::mutex> lock(stream->mutex);
+  if (!waitFor(stream->space, lock, timeout_ms,
+               [stream] { return !stream->full(); })) {
+    return 1;
+  }
+  unsigned long long seq = stream->nextSubmit++;
+  streamSlot &s = stream->slot(seq);
+  s.status = streamSlot::state::queued;
+  s.input = input_rgb;
+  s.output = output_rgb;
+  s.outputStride = output_stride;
+  s.userData = user_data;
+  s.plan = stream->plan;
+  s.submitted = std::chrono::steady_clock::now();
+  if (sequence != nullptr) {
+    *sequence = seq;
+  }
+  lock.unlock();
+  stream->queued.notify_one();
+  return 0;
+}
+
+int stream_poll(frame_stream *stream, stream_frame *frame, int timeout_ms) {
+  if (stream == nullptr || frame == nullptr || stream->callback != nullptr) {
+    return -1;
+  }
+  std::unique_lock<std::mutex> lock(stream->mutex);
+  if (!waitFor(stream->completed, lock, timeout_ms,
+               [stream] { return stream->nextDone(); })) {
+    return 1;
+  }
+  *frame = stream->frameOf(stream->nextDeliver);
+  stream->retire();
+  return 0;
+}
+
+int stream_flush(frame_stream *stream) {
+  if (stream == nullptr) {
+    return -1;
+  }
+  std::unique_lock<std::mutex> lock(stream->mutex);
+  stream->completed.wait(lock, [stream] { return stream->drained(); });
+  return 0;
+}
+
+void destroy_stream(frame_stream *stream) {
+  if (stream == nullptr) {
     return;
   }
-  // copy to output_rgb with stride
-  auto buf = static_cast<unsigned char *>(std::malloc(res.rows * stride * 3));
-  *output_rgb = buf;
-  for (int i = 0; i < res.rows; i++) {
-    memcpy(buf + i * stride, res.ptr(i), res.cols * 3);
+  {
+    std::lock_guard<std::mutex> lock(stream->mutex);
+    stream->stopping = true;
+  }
+  stream->queued.notify_all();
+  for (std::thread &t : stream->workers) {
+    t.join();
+  }
+  // 没有回调时调用方未取走的帧
+  for (unsigned long long seq = stream->nextDeliver; seq < stream->nextSubmit;
+       seq++) {
+    streamSlot &s = stream->slot(seq);
+    if (s.pooled) {
+      releaseBuffer(s.output);
+    }
   }
+  delete stream;
 }
@@ -0,0 +1,51 @@
+#ifndef OPS_H
+#define OPS_H
+
+#include <opencv2/opencv.hpp>
+
+// mylib 内部的单步调整，供 C 接口之外的 C++ 代码(如性能测试)直接调用
+
+/**
+ * 图像锐化处理
+ * @param value 锐化程度 0-100，50为默认值(不改变)
+ * @param fixedPoint 锐化(value > 50)使用定点整数实现，见 PARAM_FIXED_POINT
+ */
+cv::Mat sharpen(cv::Mat const &src, int value = 50, bool fixedPoint = false);
+
+/**
+ * 对比度调整
+ * @param value 对比度值 0-100，50为默认值(不改变)
+ */
+cv::Mat adjustContrast(cv::Mat const &src, int value = 50);
+
+/**
+ * 饱和度调整，算法由 set_saturation_mode 选择
+ * @param value 饱和度值 0-100，50为默认值(不改变)
+ */
+cv::Mat adjustSaturation(cv::Mat const &src, int value = 50);
+
+/**
+ * 亮度调整
+ * @param value 亮度值 0-100，50为默认值(不改变)
+ */
+cv::Mat adjustBrightness(cv::Mat const &src, int value = 50);
+
+/**
+ * 自动色阶，裁剪比例由 set_auto_levels_clip 设置
+ * @param value 强度 0-100，0为默认值(不改变)
+ */
+cv::Mat autoLevels(cv::Mat const &src, int value = 0);
+
+/**
+ * 边缘保持降噪(自引导滤波)
+ * @param value 强度 0-100，0为默认值(不改变)
+ */
+cv::Mat denoise(cv::Mat const &src, int value = 0);
+
+/**
+ * Lanczos-3 缩放
+ * @param percent 输出尺寸占输入的百分比 1-400，100为默认值(不改变)
+ */
+cv::Mat resample(cv::Mat const &src, int percent = 100);
+
+#endif // OPS_H
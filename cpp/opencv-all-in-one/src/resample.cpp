@@ -0,0 +1,130 @@
+#include "resample.h"
+
+#include "dispatch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <list>
+#include <mutex>
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+double lanczos3(double x) {
+  if (x == 0) {
+    return 1;
+  }
+  if (std::abs(x) >= 3) {
+    return 0;
+  }
+  double px = kPi * x;
+  return 3 * std::sin(px) * std::sin(px / 3) / (px * px);
+}
+
+std::shared_ptr<ResampleAxis const> buildAxis(int srcLen, int dstLen) {
+  auto axis = std::make_shared<ResampleAxis>();
+  axis->srcLen = srcLen;
+  axis->dstLen = dstLen;
+  if (srcLen == dstLen) {
+    axis->taps = 1;
+    axis->start.resize(dstLen);
+    for (int i = 0; i < dstLen; i++) {
+      axis->start[i] = i;
+    }
+    axis->weights.assign(dstLen, static_cast<int16_t>(1 << kResampleBits));
+    return axis;
+  }
+
+  // 像素中心对齐；缩小时核放宽 scale 倍
+  double scale = static_cast<double>(srcLen) / dstLen;
+  double filterScale = std::max(scale, 1.0);
+  double support = 3 * filterScale;
+  int taps =
+      std::min(srcLen, 2 * static_cast<int>(std::ceil(support)) + 1);
+  axis->taps = taps;
+  axis->start.resize(dstLen);
+  axis->weights.resize(static_cast<size_t>(dstLen) * taps);
+
+  std::vector<double> w(taps);
+  for (int i = 0; i < dstLen; i++) {
+    double center = (i + 0.5) * scale - 0.5;
+    int lo = static_cast<int>(std::ceil(center - support));
+    int hi = static_cast<int>(std::floor(center + support));
+    int start = std::clamp(lo, 0, srcLen - taps);
+    std::fill(w.begin(), w.end(), 0.0);
+    double sum = 0;
+    for (int j = lo; j <= hi; j++) {
+      double v = lanczos3((j - center) / filterScale);
+      w[std::clamp(j, 0, srcLen - 1) - start] += v;
+      sum += v;
+    }
+
+    // 量化后的舍入误差补到绝对值最大的系数上，保证每组之和精确为1
+    int16_t *q = &axis->weights[static_cast<size_t>(i) * taps];
+    int one = 1 << kResampleBits;
+    int total = 0;
+    int largest = 0;
+    for (int k = 0; k < taps; k++) {
+      q[k] = static_cast<int16_t>(std::lround(w[k] / sum * one));
+      total += q[k];
+      if (std::abs(q[k]) > std::abs(q[largest])) {
+        largest = k;
+      }
+    }
+    q[largest] = static_cast<int16_t>(q[largest] + one - total);
+    axis->start[i] = start;
+  }
+  return axis;
+}
+
+/**
+ * 最近使用的缩放系数，同一组尺寸反复处理(如视频帧、批量缩略图)时命中
+ */
+class AxisCache {
+public:
+  std::shared_ptr<ResampleAxis const> get(int srcLen, int dstLen) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+      if ((*it)->srcLen == srcLen && (*it)->dstLen == dstLen) {
+        entries_.splice(entries_.begin(), entries_, it);
+        return *it;
+      }
+    }
+
+    auto axis = buildAxis(srcLen, dstLen);
+    entries_.push_front(axis);
+    if (entries_.size() > kCapacity) {
+      entries_.pop_back();
+    }
+    return axis;
+  }
+
+private:
+  static constexpr size_t kCapacity = 16;
+  std::mutex mutex_;
+  std::list<std::shared_ptr<ResampleAxis const>> entries_;
+};
+
+AxisCache &cache() {
+  static AxisCache instance;
+  return instance;
+}
+
+} // namespace
+
+std::shared_ptr<ResampleAxis const> resampleAxis(int srcLen, int dstLen) {
+  return cache().get(srcLen, dstLen);
+}
+
+void resampleRow(unsigned char const *src, unsigned char *dst,
+                 ResampleAxis const &axis) {
+  kernels().resampleRow(src, dst, axis.srcLen, axis.dstLen, axis.taps,
+                        axis.start.data(), axis.weights.data());
+}
+
+void resampleColumns(unsigned char const *const *rows, int16_t const *weights,
+                     int taps, unsigned char *dst, size_t n) {
+  kernels().resampleColumns(rows, weights, taps, dst, n);
+}
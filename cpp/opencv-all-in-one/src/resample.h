@@ -0,0 +1,49 @@
+#ifndef RESAMPLE_H
+#define RESAMPLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// 缩放系数的定点小数位数，每组系数之和为 1 << kResampleBits
+constexpr int kResampleBits = 14;
+
+/**
+ * 一个方向上的 Lanczos-3 缩放系数
+ * 输出位置 i 取输入 [start[i], start[i] + taps) 的加权和；越界的抽头已合并到
+ * 边缘像素(相当于 BORDER_REPLICATE)；缩小时核按比例放宽，同时起抗混叠作用
+ */
+struct ResampleAxis {
+  int srcLen;
+  int dstLen;
+  int taps;
+  std::vector<int> start;
+  std::vector<int16_t> weights; // dstLen 组，每组 taps 个
+};
+
+/**
+ * 获取从 srcLen 缩放到 dstLen 的系数，按 (srcLen, dstLen) 缓存
+ * 长度不变时为单抽头的恒等映射
+ */
+std::shared_ptr<ResampleAxis const> resampleAxis(int srcLen, int dstLen);
+
+/**
+ * 水平方向缩放一行三通道像素
+ * @param src 输入行，axis.srcLen 个像素
+ * @param dst 输出行，axis.dstLen 个像素
+ */
+void resampleRow(unsigned char const *src, unsigned char *dst,
+                 ResampleAxis const &axis);
+
+/**
+ * 竖直方向缩放的一个输出行: dst[x] = Σ weights[k]·rows[k][x]，
+ * 按定点舍入并饱和到 [0, 255]
+ * @param rows taps 个输入行
+ * @param weights taps 个系数
+ * @param n 每行字节数
+ */
+void resampleColumns(unsigned char const *const *rows, int16_t const *weights,
+                     int taps, unsigned char *dst, size_t n);
+
+#endif // RESAMPLE_H
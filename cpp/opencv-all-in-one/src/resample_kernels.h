@@ -0,0 +1,159 @@
+// 缩放内核，只能由 kernels_impl.h 在各版本的命名空间内包含
+
+constexpr int kResampleRound = 1 << (kResampleBits - 1);
+
+/**
+ * 定点累加结果舍入并饱和为8位，与SIMD版本的 srai/packs/packus 一致
+ */
+inline unsigned char resampleClamp(int acc) {
+  return static_cast<unsigned char>(
+      minOf(maxOf((acc + kResampleRound) >> kResampleBits, 0), 255));
+}
+
+/**
+ * 两个 int16 系数拼成 madd 使用的一对
+ */
+inline int weightPair(int16_t a, int16_t b) {
+  return static_cast<int>(static_cast<uint32_t>(static_cast<uint16_t>(a)) |
+                          static_cast<uint32_t>(static_cast<uint16_t>(b))
+                              << 16);
+}
+
+void resampleRow(unsigned char const *src, unsigned char *dst, int src_width,
+                 int dst_width, int taps, int const *start,
+                 int16_t const *weights) {
+  int x = 0;
+#if defined(MYLIB_KERNEL_SSE41)
+  // 每次读取8个字节(两个像素及下一像素的前两个字节)，用 pshufb 重排为
+  // b0 b1 g0 g1 r0 r1 的16位对，与两个抽头的系数对做 madd，累加器的前三个
+  // 元素即为三个通道；start 单调不减，读取会越过行尾的像素留给标量处理
+  __m128i const order = _mm_setr_epi8(0, -1, 3, -1, 1, -1, 4, -1, 2, -1, 5,
+                                      -1, -1, -1, -1, -1);
+  __m128i const round = _mm_set1_epi32(kResampleRound);
+  for (; x < dst_width && start[x] + taps + 2 <= src_width; x++) {
+    unsigned char const *p = src + start[x] * 3;
+    int16_t const *w = weights + x * taps;
+    __m128i acc = round;
+    int k = 0;
+    for (; k + 2 <= taps; k += 2) {
+      __m128i v = _mm_shuffle_epi8(
+          _mm_loadl_epi64(reinterpret_cast<__m128i const *>(p + k * 3)),
+          order);
+      acc = _mm_add_epi32(
+          acc, _mm_madd_epi16(v, _mm_set1_epi32(weightPair(w[k], w[k + 1]))));
+    }
+    if (k < taps) {
+      __m128i v = _mm_shuffle_epi8(
+          _mm_loadl_epi64(reinterpret_cast<__m128i const *>(p + k * 3)),
+          order);
+      acc = _mm_add_epi32(
+          acc, _mm_madd_epi16(v, _mm_set1_epi32(weightPair(w[k], 0))));
+    }
+    __m128i r = _mm_srai_epi32(acc, kResampleBits);
+    r = _mm_packus_epi16(_mm_packs_epi32(r, r), r);
+    int packed = _mm_cvtsi128_si32(r);
+    memcpy(dst + x * 3, &packed, 3);
+  }
+#else
+  (void)src_width;
+#endif
+
+  for (; x < dst_width; x++) {
+    unsigned char const *p = src + start[x] * 3;
+    int16_t const *w = weights + x * taps;
+    int acc[3] = {0, 0, 0};
+    for (int k = 0; k < taps; k++) {
+      acc[0] += w[k] * p[k * 3];
+      acc[1] += w[k] * p[k * 3 + 1];
+      acc[2] += w[k] * p[k * 3 + 2];
+    }
+    for (int c = 0; c < 3; c++) {
+      dst[x * 3 + c] = resampleClamp(acc[c]);
+    }
+  }
+}
+
+void resampleColumns(unsigned char const *const *rows, int16_t const *weights,
+                     int taps, unsigned char *dst, size_t n) {
+  size_t i = 0;
+  // 两行交错后扩展为16位，与两个抽头的系数对做 madd；
+  // 解包与打包都在128位通道内进行，打包后恢复原来的字节顺序
+#if defined(MYLIB_KERNEL_AVX2)
+  {
+    __m256i const zero = _mm256_setzero_si256();
+    __m256i const round = _mm256_set1_epi32(kResampleRound);
+    for (; i + 32 <= n; i += 32) {
+      __m256i acc[4] = {round, round, round, round};
+      for (int k = 0; k < taps; k += 2) {
+        __m256i a = _mm256_loadu_si256(
+            reinterpret_cast<__m256i const *>(rows[k] + i));
+        __m256i b = k + 1 < taps ? _mm256_loadu_si256(
+                                       reinterpret_cast<__m256i const *>(
+                                           rows[k + 1] + i))
+                                 : zero;
+        __m256i w = _mm256_set1_epi32(
+            weightPair(weights[k], k + 1 < taps ? weights[k + 1] : 0));
+        __m256i lo = _mm256_unpacklo_epi8(a, b);
+        __m256i hi = _mm256_unpackhi_epi8(a, b);
+        acc[0] = _mm256_add_epi32(
+            acc[0], _mm256_madd_epi16(_mm256_unpacklo_epi8(lo, zero), w));
+        acc[1] = _mm256_add_epi32(
+            acc[1], _mm256_madd_epi16(_mm256_unpackhi_epi8(lo, zero), w));
+        acc[2] = _mm256_add_epi32(
+            acc[2], _mm256_madd_epi16(_mm256_unpacklo_epi8(hi, zero), w));
+        acc[3] = _mm256_add_epi32(
+            acc[3], _mm256_madd_epi16(_mm256_unpackhi_epi8(hi, zero), w));
+      }
+      for (__m256i &v : acc) {
+        v = _mm256_srai_epi32(v, kResampleBits);
+      }
+      __m256i r = _mm256_packus_epi16(_mm256_packs_epi32(acc[0], acc[1]),
+                                      _mm256_packs_epi32(acc[2], acc[3]));
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), r);
+    }
+  }
+#endif
+#if defined(MYLIB_KERNEL_SSE2)
+  {
+    __m128i const zero = _mm_setzero_si128();
+    __m128i const round = _mm_set1_epi32(kResampleRound);
+    for (; i + 16 <= n; i += 16) {
+      __m128i acc[4] = {round, round, round, round};
+      for (int k = 0; k < taps; k += 2) {
+        __m128i a =
+            _mm_loadu_si128(reinterpret_cast<__m128i const *>(rows[k] + i));
+        __m128i b = k + 1 < taps ? _mm_loadu_si128(
+                                       reinterpret_cast<__m128i const *>(
+                                           rows[k + 1] + i))
+                                 : zero;
+        __m128i w = _mm_set1_epi32(
+            weightPair(weights[k], k + 1 < taps ? weights[k + 1] : 0));
+        __m128i lo = _mm_unpacklo_epi8(a, b);
+        __m128i hi = _mm_unpackhi_epi8(a, b);
+        acc[0] = _mm_add_epi32(acc[0],
+                               _mm_madd_epi16(_mm_unpacklo_epi8(lo, zero), w));
+        acc[1] = _mm_add_epi32(acc[1],
+                               _mm_madd_epi16(_mm_unpackhi_epi8(lo, zero), w));
+        acc[2] = _mm_add_epi32(acc[2],
+                               _mm_madd_epi16(_mm_unpacklo_epi8(hi, zero), w));
+        acc[3] = _mm_add_epi32(acc[3],
+                               _mm_madd_epi16(_mm_unpackhi_epi8(hi, zero), w));
+      }
+      for (__m128i &v : acc) {
+        v = _mm_srai_epi32(v, kResampleBits);
+      }
+      __m128i r = _mm_packus_epi16(_mm_packs_epi32(acc[0], acc[1]),
+                                   _mm_packs_epi32(acc[2], acc[3]));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), r);
+    }
+  }
+#endif
+
+  for (; i < n; i++) {
+    int acc = 0;
+    for (int k = 0; k < taps; k++) {
+      acc += weights[k] * rows[k][i];
+    }
+    dst[i] = resampleClamp(acc);
+  }
+}
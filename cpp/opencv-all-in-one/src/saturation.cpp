@@ -0,0 +1,16 @@
+#include "saturation.h"
+
+#include "dispatch.h"
+
+float saturationFactor(int value) {
+  float factor = value / 50.0f;
+  if (factor > 1.0f) {
+    factor = 1.0f + (factor - 1.0f) * 2.0f; // 50-100映射到1.0-3.0
+  }
+  return factor;
+}
+
+void saturateRow(unsigned char const *src, unsigned char *dst, int pixels,
+                 float factor, SaturationMode mode) {
+  kernels().saturateRow(src, dst, pixels, factor, mode);
+}
@@ -0,0 +1,30 @@
+#ifndef SATURATION_H
+#define SATURATION_H
+
+/**
+ * 饱和度调整算法
+ */
+enum class SaturationMode {
+  hsv = 0,       // 原实现: BGR->HSV，缩放S通道后转回
+  luma = 1,      // 在RGB空间向亮度(Rec.601)混合，定点SIMD实现
+  hsvCompat = 2, // 在RGB空间直接缩放HSV饱和度，保持H和V，与 hsv 模式误差很小
+};
+
+/**
+ * 将0-100的饱和度值映射为缩放系数
+ * 0-50映射到0.0-1.0，50-100映射到1.0-3.0
+ */
+float saturationFactor(int value);
+
+/**
+ * 对一行RGB像素做饱和度调整，允许 src 与 dst 相同
+ * @param src 输入像素，按 R,G,B 交错排列
+ * @param dst 输出像素
+ * @param pixels 像素个数
+ * @param factor 缩放系数，见 saturationFactor
+ * @param mode 只接受 luma 或 hsvCompat
+ */
+void saturateRow(unsigned char const *src, unsigned char *dst, int pixels,
+                 float factor, SaturationMode mode);
+
+#endif // SATURATION_H
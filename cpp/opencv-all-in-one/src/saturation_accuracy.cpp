@@ -0,0 +1,90 @@
+#include <interface.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+/**
+ * 用 mode 对 rgb 做饱和度调整(type 2)
+ * @return 结果，失败时为空
+ */
+static cv::Mat saturate(cv::Mat const &rgb, int mode, int value,
+                        double &ms) {
+  set_saturation_mode(mode);
+  param p{2, value};
+  int width = 0, height = 0, stride = 0;
+  unsigned char *out = nullptr;
+  int64 t0 = cv::getTickCount();
+  int rc = processrgb_chain(&p, 1, rgb.data, rgb.cols, rgb.rows,
+                            static_cast<int>(rgb.step[0]), &width, &height,
+                            &stride, &out);
+  ms = (cv::getTickCount() - t0) * 1000.0 / cv::getTickFrequency();
+  if (rc != 0 || out == nullptr) {
+    return cv::Mat();
+  }
+  cv::Mat result = cv::Mat(height, width, CV_8UC3, out, stride).clone();
+  std::free(out);
+  return result;
+}
+
+/**
+ * 对比饱和度算法与 HSV 实现(mode 0)的误差和耗时，供切换默认算法前验证
+ * 用法: saturation_accuracy [--mode 1|2] 图像路径...
+ * 每幅图像按各个 value 输出最大误差、平均误差、误差超过2的通道值比例
+ * 以及两者的耗时
+ */
+int main(int argc, char **argv) {
+  int mode = 2;
+  std::vector<std::string> paths;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--mode") == 0 && i + 1 < argc) {
+      mode = std::atoi(argv[++i]);
+    } else {
+      paths.push_back(argv[i]);
+    }
+  }
+  if (paths.empty() || (mode != 1 && mode != 2)) {
+    std::fprintf(stderr, "用法: saturation_accuracy [--mode 1|2] 图像...\n");
+    return 2;
+  }
+
+  for (std::string const &path : paths) {
+    cv::Mat bgr = cv::imread(path, cv::IMREAD_COLOR);
+    if (bgr.empty()) {
+      std::fprintf(stderr, "无法读取图像: %s\n", path.c_str());
+      return 1;
+    }
+    cv::Mat rgb;
+    cv::cvtColor(bgr, rgb, cv::COLOR_BGR2RGB);
+
+    std::printf("%s (%dx%d), mode %d vs mode 0\n", path.c_str(), rgb.cols,
+                rgb.rows, mode);
+    std::printf("%6s %6s %8s %8s %10s %10s\n", "value", "max", "mean",
+                "over2%", "hsv_ms", "mode_ms");
+    for (int value : {0, 10, 25, 40, 60, 75, 90, 100}) {
+      double hsvMs = 0, modeMs = 0;
+      cv::Mat reference = saturate(rgb, 0, value, hsvMs);
+      cv::Mat result = saturate(rgb, mode, value, modeMs);
+      if (reference.empty() || result.empty()) {
+        std::fprintf(stderr, "处理失败: value %d\n", value);
+        return 1;
+      }
+
+      cv::Mat diff;
+      cv::absdiff(reference, result, diff);
+      diff = diff.reshape(1);
+      double maxErr = 0;
+      cv::minMaxLoc(diff, nullptr, &maxErr);
+      double meanErr = cv::mean(diff)[0];
+      double over = 100.0 * cv::countNonZero(diff > 2) / diff.total();
+      std::printf("%6d %6.0f %8.3f %8.3f %10.2f %10.2f\n", value, maxErr,
+                  meanErr, over, hsvMs, modeMs);
+    }
+  }
+  set_saturation_mode(0);
+  return 0;
+}
@@ -0,0 +1,313 @@
+// 饱和度内核，只能由 kernels_impl.h 在各版本的命名空间内包含
+
+// Rec.601 亮度权重，Q8 定点: 0.299, 0.587, 0.114
+constexpr int kWeightR = 77;
+constexpr int kWeightG = 150;
+constexpr int kWeightB = 29;
+
+/**
+ * 向亮度混合的标量实现，与SIMD版本逐位一致:
+ * Y = (77R + 150G + 29B + 128) >> 8
+ * c' = Y + round((c - Y) * f)，f 为 Q8 定点
+ */
+void lumaScalar(unsigned char const *src, unsigned char *dst, int pixels,
+                int factorQ8) {
+  for (int i = 0; i < pixels; i++) {
+    int r = src[i * 3];
+    int g = src[i * 3 + 1];
+    int b = src[i * 3 + 2];
+    int y = (kWeightR * r + kWeightG * g + kWeightB * b + 128) >> 8;
+    int c[3] = {r, g, b};
+    for (int k = 0; k < 3; k++) {
+      int v = y + (((c[k] - y) * 128 * factorQ8 + 0x4000) >> 15);
+      dst[i * 3 + k] = static_cast<unsigned char>(minOf(maxOf(v, 0), 255));
+    }
+  }
+}
+
+/**
+ * 在RGB空间等效地缩放HSV饱和度:
+ * V = max 不变，各通道到 max 的距离按 k 缩放，色相比例保持不变；
+ * k = min(f, max / (max - min)) 对应 S 饱和到 1 的情况
+ */
+void hsvCompatScalar(unsigned char const *src, unsigned char *dst, int pixels,
+                     float factor) {
+  for (int i = 0; i < pixels; i++) {
+    int c[3] = {src[i * 3], src[i * 3 + 1], src[i * 3 + 2]};
+    int mx = maxOf(maxOf(c[0], c[1]), c[2]);
+    int mn = minOf(minOf(c[0], c[1]), c[2]);
+    float k = factor;
+    if (mx > mn) {
+      float limit = static_cast<float>(mx) / (mx - mn);
+      k = limit < factor ? limit : factor;
+    }
+    // k <= max / (max - min)，结果必然落在 [0, max] 内
+    for (int j = 0; j < 3; j++) {
+      float v = mx - k * (mx - c[j]);
+      dst[i * 3 + j] = static_cast<unsigned char>(lrintf(v));
+    }
+  }
+}
+
+#if defined(MYLIB_KERNEL_SSE41)
+
+/**
+ * 16个交错的RGB像素(48字节)拆分为 R、G、B 三个平面
+ */
+inline void deinterleave16(unsigned char const *p, __m128i &r, __m128i &g,
+                           __m128i &b) {
+  __m128i a = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p));
+  __m128i m = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p + 16));
+  __m128i z = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p + 32));
+
+  r = _mm_or_si128(
+      _mm_or_si128(_mm_shuffle_epi8(a, _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1,
+                                                     -1, -1, -1, -1, -1, -1,
+                                                     -1, -1)),
+                   _mm_shuffle_epi8(m, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2,
+                                                     5, 8, 11, 14, -1, -1, -1,
+                                                     -1, -1))),
+      _mm_shuffle_epi8(z, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                        -1, 1, 4, 7, 10, 13)));
+  g = _mm_or_si128(
+      _mm_or_si128(_mm_shuffle_epi8(a, _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1,
+                                                     -1, -1, -1, -1, -1, -1,
+                                                     -1, -1, -1)),
+                   _mm_shuffle_epi8(m, _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3,
+                                                     6, 9, 12, 15, -1, -1, -1,
+                                                     -1, -1))),
+      _mm_shuffle_epi8(z, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                        -1, 2, 5, 8, 11, 14)));
+  b = _mm_or_si128(
+      _mm_or_si128(_mm_shuffle_epi8(a, _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1,
+                                                     -1, -1, -1, -1, -1, -1,
+                                                     -1, -1, -1)),
+                   _mm_shuffle_epi8(m, _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4,
+                                                     7, 10, 13, -1, -1, -1, -1,
+                                                     -1, -1))),
+      _mm_shuffle_epi8(z, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                        0, 3, 6, 9, 12, 15)));
+}
+
+/**
+ * deinterleave16 的逆操作
+ */
+inline void interleave16(unsigned char *p, __m128i r, __m128i g, __m128i b) {
+  __m128i a = _mm_or_si128(
+      _mm_or_si128(_mm_shuffle_epi8(r, _mm_setr_epi8(0, -1, -1, 1, -1, -1, 2,
+                                                     -1, -1, 3, -1, -1, 4, -1,
+                                                     -1, 5)),
+                   _mm_shuffle_epi8(g, _mm_setr_epi8(-1, 0, -1, -1, 1, -1, -1,
+                                                     2, -1, -1, 3, -1, -1, 4,
+                                                     -1, -1))),
+      _mm_shuffle_epi8(b, _mm_setr_epi8(-1, -1, 0, -1, -1, 1, -1, -1, 2, -1, -1,
+                                        3, -1, -1, 4, -1)));
+  __m128i m = _mm_or_si128(
+      _mm_or_si128(_mm_shuffle_epi8(r, _mm_setr_epi8(-1, -1, 6, -1, -1, 7, -1,
+                                                     -1, 8, -1, -1, 9, -1, -1,
+                                                     10, -1)),
+                   _mm_shuffle_epi8(g, _mm_setr_epi8(5, -1, -1, 6, -1, -1, 7,
+                                                     -1, -1, 8, -1, -1, 9, -1,
+                                                     -1, 10))),
+      _mm_shuffle_epi8(b, _mm_setr_epi8(-1, 5, -1, -1, 6, -1, -1, 7, -1, -1, 8,
+                                        -1, -1, 9, -1, -1)));
+  __m128i z = _mm_or_si128(
+      _mm_or_si128(_mm_shuffle_epi8(r, _mm_setr_epi8(-1, 11, -1, -1, 12, -1, -1,
+                                                     13, -1, -1, 14, -1, -1,
+                                                     15, -1, -1)),
+                   _mm_shuffle_epi8(g, _mm_setr_epi8(-1, -1, 11, -1, -1, 12, -1,
+                                                     -1, 13, -1, -1, 14, -1,
+                                                     -1, 15, -1))),
+      _mm_shuffle_epi8(b, _mm_setr_epi8(10, -1, -1, 11, -1, -1, 12, -1, -1, 13,
+                                        -1, -1, 14, -1, -1, 15)));
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(p), a);
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(p + 16), m);
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(p + 32), z);
+}
+
+#endif
+
+#if defined(MYLIB_KERNEL_AVX2)
+
+inline __m256i lumaChannel(__m256i c, __m256i y, __m256i f) {
+  __m256i d = _mm256_slli_epi16(_mm256_sub_epi16(c, y), 7);
+  return _mm256_add_epi16(y, _mm256_mulhrs_epi16(d, f));
+}
+
+inline __m128i pack256(__m256i v) {
+  return _mm_packus_epi16(_mm256_castsi256_si128(v),
+                          _mm256_extracti128_si256(v, 1));
+}
+
+int lumaSimd(unsigned char const *src, unsigned char *dst, int pixels,
+             int factorQ8) {
+  __m256i const wr = _mm256_set1_epi16(kWeightR);
+  __m256i const wg = _mm256_set1_epi16(kWeightG);
+  __m256i const wb = _mm256_set1_epi16(kWeightB);
+  __m256i const half = _mm256_set1_epi16(128);
+  __m256i const f = _mm256_set1_epi16(static_cast<short>(factorQ8));
+  int i = 0;
+  for (; i + 16 <= pixels; i += 16) {
+    __m128i r8, g8, b8;
+    deinterleave16(src + i * 3, r8, g8, b8);
+    __m256i r = _mm256_cvtepu8_epi16(r8);
+    __m256i g = _mm256_cvtepu8_epi16(g8);
+    __m256i b = _mm256_cvtepu8_epi16(b8);
+    // 加权和最大 65408，按无符号16位计算后逻辑右移
+    __m256i y = _mm256_add_epi16(_mm256_mullo_epi16(r, wr),
+                                 _mm256_mullo_epi16(g, wg));
+    y = _mm256_add_epi16(y, _mm256_mullo_epi16(b, wb));
+    y = _mm256_srli_epi16(_mm256_add_epi16(y, half), 8);
+    interleave16(dst + i * 3, pack256(lumaChannel(r, y, f)),
+                 pack256(lumaChannel(g, y, f)), pack256(lumaChannel(b, y, f)));
+  }
+  return i;
+}
+
+/**
+ * hsvCompat 的一个通道: c' = max - k * (max - c)，8个像素
+ */
+inline __m256i compatChannel(__m256 mx, __m256 k, __m128i c8) {
+  __m256 c = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(c8));
+  __m256 v = _mm256_sub_ps(mx, _mm256_mul_ps(k, _mm256_sub_ps(mx, c)));
+  return _mm256_cvtps_epi32(v);
+}
+
+/**
+ * 8个 int32 饱和收窄为 int16
+ */
+inline __m128i narrow32(__m256i v) {
+  return _mm_packs_epi32(_mm256_castsi256_si128(v),
+                         _mm256_extracti128_si256(v, 1));
+}
+
+int compatSimd(unsigned char const *src, unsigned char *dst, int pixels,
+               float factor) {
+  __m256 const f = _mm256_set1_ps(factor);
+  int i = 0;
+  for (; i + 16 <= pixels; i += 16) {
+    __m128i c8[3];
+    deinterleave16(src + i * 3, c8[0], c8[1], c8[2]);
+    __m128i mx8 = _mm_max_epu8(_mm_max_epu8(c8[0], c8[1]), c8[2]);
+    __m128i mn8 = _mm_min_epu8(_mm_min_epu8(c8[0], c8[1]), c8[2]);
+    __m128i out[3][2];
+    for (int half = 0; half < 2; half++) {
+      __m256 mx = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(mx8));
+      __m256 mn = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(mn8));
+      // max == min 时除法得到 inf 或 NaN，min_ps 遇到 NaN 返回第二个操作数 f
+      __m256 k = _mm256_min_ps(_mm256_div_ps(mx, _mm256_sub_ps(mx, mn)), f);
+      for (int j = 0; j < 3; j++) {
+        out[j][half] = narrow32(compatChannel(mx, k, c8[j]));
+        c8[j] = _mm_srli_si128(c8[j], 8);
+      }
+      mx8 = _mm_srli_si128(mx8, 8);
+      mn8 = _mm_srli_si128(mn8, 8);
+    }
+    interleave16(dst + i * 3, _mm_packus_epi16(out[0][0], out[0][1]),
+                 _mm_packus_epi16(out[1][0], out[1][1]),
+                 _mm_packus_epi16(out[2][0], out[2][1]));
+  }
+  return i;
+}
+
+#elif defined(MYLIB_KERNEL_SSE41)
+
+inline __m128i lumaChannel(__m128i c, __m128i y, __m128i f) {
+  __m128i d = _mm_slli_epi16(_mm_sub_epi16(c, y), 7);
+  return _mm_add_epi16(y, _mm_mulhrs_epi16(d, f));
+}
+
+inline __m128i lumaOf(__m128i r, __m128i g, __m128i b) {
+  __m128i y = _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(kWeightR)),
+                            _mm_mullo_epi16(g, _mm_set1_epi16(kWeightG)));
+  y = _mm_add_epi16(y, _mm_mullo_epi16(b, _mm_set1_epi16(kWeightB)));
+  return _mm_srli_epi16(_mm_add_epi16(y, _mm_set1_epi16(128)), 8);
+}
+
+int lumaSimd(unsigned char const *src, unsigned char *dst, int pixels,
+             int factorQ8) {
+  __m128i const f = _mm_set1_epi16(static_cast<short>(factorQ8));
+  __m128i const zero = _mm_setzero_si128();
+  int i = 0;
+  for (; i + 16 <= pixels; i += 16) {
+    __m128i r8, g8, b8;
+    deinterleave16(src + i * 3, r8, g8, b8);
+    __m128i out[3][2];
+    for (int half = 0; half < 2; half++) {
+      __m128i r = half ? _mm_unpackhi_epi8(r8, zero) : _mm_cvtepu8_epi16(r8);
+      __m128i g = half ? _mm_unpackhi_epi8(g8, zero) : _mm_cvtepu8_epi16(g8);
+      __m128i b = half ? _mm_unpackhi_epi8(b8, zero) : _mm_cvtepu8_epi16(b8);
+      __m128i y = lumaOf(r, g, b);
+      out[0][half] = lumaChannel(r, y, f);
+      out[1][half] = lumaChannel(g, y, f);
+      out[2][half] = lumaChannel(b, y, f);
+    }
+    interleave16(dst + i * 3, _mm_packus_epi16(out[0][0], out[0][1]),
+                 _mm_packus_epi16(out[1][0], out[1][1]),
+                 _mm_packus_epi16(out[2][0], out[2][1]));
+  }
+  return i;
+}
+
+/**
+ * hsvCompat 的一个通道: c' = max - k * (max - c)，4个像素
+ */
+inline __m128i compatChannel(__m128 mx, __m128 k, __m128i c8) {
+  __m128 c = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(c8));
+  return _mm_cvtps_epi32(_mm_sub_ps(mx, _mm_mul_ps(k, _mm_sub_ps(mx, c))));
+}
+
+int compatSimd(unsigned char const *src, unsigned char *dst, int pixels,
+               float factor) {
+  __m128 const f = _mm_set1_ps(factor);
+  int i = 0;
+  for (; i + 16 <= pixels; i += 16) {
+    __m128i c8[3];
+    deinterleave16(src + i * 3, c8[0], c8[1], c8[2]);
+    __m128i mx8 = _mm_max_epu8(_mm_max_epu8(c8[0], c8[1]), c8[2]);
+    __m128i mn8 = _mm_min_epu8(_mm_min_epu8(c8[0], c8[1]), c8[2]);
+    __m128i out[3][4];
+    for (int q = 0; q < 4; q++) {
+      __m128 mx = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(mx8));
+      __m128 mn = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(mn8));
+      // max == min 时除法得到 inf 或 NaN，min_ps 遇到 NaN 返回第二个操作数 f
+      __m128 k = _mm_min_ps(_mm_div_ps(mx, _mm_sub_ps(mx, mn)), f);
+      for (int j = 0; j < 3; j++) {
+        out[j][q] = compatChannel(mx, k, c8[j]);
+        c8[j] = _mm_srli_si128(c8[j], 4);
+      }
+      mx8 = _mm_srli_si128(mx8, 4);
+      mn8 = _mm_srli_si128(mn8, 4);
+    }
+    __m128i res[3];
+    for (int j = 0; j < 3; j++) {
+      res[j] = _mm_packus_epi16(_mm_packs_epi32(out[j][0], out[j][1]),
+                                _mm_packs_epi32(out[j][2], out[j][3]));
+    }
+    interleave16(dst + i * 3, res[0], res[1], res[2]);
+  }
+  return i;
+}
+
+#else
+
+int lumaSimd(unsigned char const *, unsigned char *, int, int) { return 0; }
+
+int compatSimd(unsigned char const *, unsigned char *, int, float) {
+  return 0;
+}
+
+#endif
+
+void saturateRow(unsigned char const *src, unsigned char *dst, int pixels,
+                 float factor, SaturationMode mode) {
+  if (mode == SaturationMode::hsvCompat) {
+    int done = compatSimd(src, dst, pixels, factor);
+    hsvCompatScalar(src + done * 3, dst + done * 3, pixels - done, factor);
+    return;
+  }
+
+  int factorQ8 = static_cast<int>(lrintf(factor * 256.0f));
+  int done = lumaSimd(src, dst, pixels, factorQ8);
+  lumaScalar(src + done * 3, dst + done * 3, pixels - done, factorQ8);
+}
@@ -0,0 +1,175 @@
+#include <interface.h>
+
+#include "shm_ring.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * 帧交换区的测试客户端：连接 mylib_shm_host，把合成帧写入槽位并提交，
+ * 统计往返耗时；--verify 时与本进程内 processrgb_chain_into 的结果逐字节比较
+ */
+
+static void usage(char const *prog) {
+  std::cout << "用法: " << prog << " [选项]\n"
+            << "  -n, --name <名字>        共享内存名，默认 /mylib_frames\n"
+            << "  -p, --op <type:value>    调整步骤，可用逗号分隔，默认 0:80\n"
+            << "      --size <宽x高>       帧尺寸，默认 1920x1080\n"
+            << "  -f, --frames <n>         帧数，默认 100\n"
+            << "      --verify             与进程内的处理结果比较\n";
+}
+
+static bool parseOps(std::string const &text, std::vector<param> &ops) {
+  size_t pos = 0;
+  while (pos <= text.size()) {
+    size_t end = std::min(text.find(',', pos), text.size());
+    param p;
+    if (std::sscanf(text.substr(pos, end - pos).c_str(), "%d:%d", &p.type,
+                    &p.value) != 2) {
+      return false;
+    }
+    ops.push_back(p);
+    pos = end + 1;
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  std::string name = "/mylib_frames";
+  std::vector<param> ops;
+  int width = 1920;
+  int height = 1080;
+  int frames = 100;
+  bool verify = false;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    char const *v = i + 1 < argc ? argv[i + 1] : nullptr;
+    bool ok = true;
+    if (arg == "-h" || arg == "--help") {
+      usage(argv[0]);
+      return 0;
+    } else if (arg == "--verify") {
+      verify = true;
+      continue;
+    } else if (v == nullptr) {
+      ok = false;
+    } else if (arg == "-n" || arg == "--name") {
+      name = v;
+    } else if (arg == "-p" || arg == "--op") {
+      ok = parseOps(v, ops);
+    } else if (arg == "--size") {
+      ok = std::sscanf(v, "%dx%d", &width, &height) == 2 && width > 0 &&
+           height > 0;
+    } else if (arg == "-f" || arg == "--frames") {
+      ok = std::sscanf(v, "%d", &frames) == 1;
+    } else {
+      ok = false;
+    }
+    if (!ok) {
+      std::cerr << "无效的参数: " << arg << std::endl;
+      usage(argv[0]);
+      return 1;
+    }
+    i++;
+  }
+  if (ops.empty()) {
+    ops.push_back(param{0, 80});
+  }
+
+  auto ring = FrameRing::open(name);
+  if (!ring) {
+    return 1;
+  }
+  int stride = (width * 3 + 63) & ~63;
+  size_t bytes = static_cast<size_t>(stride) * height;
+  if (bytes > ring->slotBytes()) {
+    std::cerr << "帧大小超出槽位(" << ring->slotBytes() << " 字节)"
+              << std::endl;
+    return 1;
+  }
+
+  // 合成输入帧，模拟解码器直接输出到槽位
+  std::mt19937 rng(1);
+  std::vector<unsigned char> source(bytes);
+  for (unsigned char &b : source) {
+    b = static_cast<unsigned char>(rng());
+  }
+  std::vector<unsigned char> expected;
+  if (verify) {
+    expected = source;
+    if (processrgb_chain_into(ops.data(), static_cast<int>(ops.size()),
+                              expected.data(), width, height, stride,
+                              expected.data(), width, height, stride) != 0) {
+      std::cerr << "无效的调整步骤" << std::endl;
+      return 1;
+    }
+  }
+
+  using clock = std::chrono::steady_clock;
+  struct inFlight {
+    int slot;
+    clock::time_point submitted;
+  };
+  std::deque<inFlight> pending;
+  std::vector<double> latencies;
+  int submitted = 0;
+  int mismatches = 0;
+  auto start = clock::now();
+  while (submitted < frames || !pending.empty()) {
+    // 尽量占满所有槽位，主机按提交顺序处理
+    int slot = submitted < frames ? ring->acquire() : -1;
+    if (slot >= 0) {
+      std::memcpy(ring->pixels(slot), source.data(), bytes);
+      if (!ring->submit(slot, ops.data(), static_cast<int>(ops.size()), width,
+                        height, stride)) {
+        std::cerr << "提交失败" << std::endl;
+        return 1;
+      }
+      pending.push_back(inFlight{slot, clock::now()});
+      submitted++;
+      continue;
+    }
+
+    if (pending.empty()) {
+      // 槽位都被其他客户端占用
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      continue;
+    }
+    inFlight f = pending.front();
+    pending.pop_front();
+    if (!ring->wait(f.slot, -1)) {
+      std::cerr << "主机已退出" << std::endl;
+      return 1;
+    }
+    latencies.push_back(
+        std::chrono::duration<double, std::milli>(clock::now() - f.submitted)
+            .count());
+    if (ring->slot(f.slot).status != 0 ||
+        (verify && std::memcmp(ring->pixels(f.slot), expected.data(),
+                               bytes) != 0)) {
+      mismatches++;
+    }
+    ring->release(f.slot);
+  }
+  double total =
+      std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+  std::sort(latencies.begin(), latencies.end());
+  double median = latencies.empty() ? 0 : latencies[latencies.size() / 2];
+  std::printf("%d 帧 %dx%d，%.1f 帧/秒，往返耗时中位数 %.3f ms，最大 %.3f ms\n",
+              frames, width, height, frames * 1000.0 / total, median,
+              latencies.empty() ? 0 : latencies.back());
+  if (mismatches > 0) {
+    std::printf("%d 帧失败或与进程内结果不一致\n", mismatches);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,105 @@
+#include <interface.h>
+
+#include "shm_ring.h"
+
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+/**
+ * 帧交换区的主机进程：创建共享内存，按提交顺序在槽位上原地执行 mylib，
+ * 供其他进程(如桌面前端)调用 mylib 而不必序列化整幅图像
+ */
+
+static volatile std::sig_atomic_t gStop = 0;
+
+static void onSignal(int) { gStop = 1; }
+
+static void usage(char const *prog) {
+  std::cout << "用法: " << prog << " [选项]\n"
+            << "  -n, --name <名字>        共享内存名，默认 /mylib_frames\n"
+            << "  -s, --slots <n>          槽位数，默认 4\n"
+            << "      --max-size <宽x高>   单帧最大尺寸，默认 3840x2160\n"
+            << "  -j, --threads <n>        mylib 内部线程数，默认为硬件线程数\n"
+            << "收到 SIGINT/SIGTERM 后退出并删除共享内存\n";
+}
+
+int main(int argc, char **argv) {
+  std::string name = "/mylib_frames";
+  int slots = 4;
+  int maxWidth = 3840;
+  int maxHeight = 2160;
+  int threads = 0;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    char const *v = i + 1 < argc ? argv[i + 1] : nullptr;
+    bool ok = v != nullptr;
+    if (arg == "-h" || arg == "--help") {
+      usage(argv[0]);
+      return 0;
+    } else if (ok && (arg == "-n" || arg == "--name")) {
+      name = v;
+    } else if (ok && (arg == "-s" || arg == "--slots")) {
+      ok = std::sscanf(v, "%d", &slots) == 1;
+    } else if (ok && arg == "--max-size") {
+      ok = std::sscanf(v, "%dx%d", &maxWidth, &maxHeight) == 2 &&
+           maxWidth > 0 && maxHeight > 0;
+    } else if (ok && (arg == "-j" || arg == "--threads")) {
+      ok = std::sscanf(v, "%d", &threads) == 1;
+    } else {
+      ok = false;
+    }
+    if (!ok) {
+      std::cerr << "无效的参数: " << arg << std::endl;
+      usage(argv[0]);
+      return 1;
+    }
+    i++;
+  }
+
+  // 每行按64字节对齐，客户端可以使用对齐的步长
+  size_t stride = (static_cast<size_t>(maxWidth) * 3 + 63) & ~size_t{63};
+  auto ring = FrameRing::create(name, slots, stride * maxHeight);
+  if (!ring) {
+    return 1;
+  }
+  set_num_threads(threads);
+  std::signal(SIGINT, onSignal);
+  std::signal(SIGTERM, onSignal);
+  std::cerr << "帧交换区 " << name << ": " << ring->slots() << " 个槽位，每个 "
+            << ring->slotBytes() << " 字节" << std::endl;
+
+  unsigned long long frames = 0;
+  while (!gStop) {
+    int i = ring->next(100);
+    if (i < 0) {
+      continue;
+    }
+    // 槽位内容可以被客户端随时改写，只使用校验过的副本
+    shmRequest r;
+    if (!ring->request(i, r)) {
+      ring->complete(i, -1);
+      frames++;
+      continue;
+    }
+    unsigned char *data = ring->pixels(i);
+    // 结果原地写回槽位，不接受改变尺寸的步骤(缩放)
+    int w = 0;
+    int h = 0;
+    int status =
+        processrgb_chain_size(r.params, r.count, r.width, r.height, &w, &h);
+    if (status == 0 && (w != r.width || h != r.height)) {
+      status = -1;
+    } else if (status == 0) {
+      status = processrgb_chain_into(r.params, r.count, data, r.width,
+                                     r.height, r.stride, data, r.width,
+                                     r.height, r.stride);
+    }
+    ring->complete(i, status);
+    frames++;
+  }
+  std::cerr << "退出，共处理 " << frames << " 帧" << std::endl;
+  return 0;
+}
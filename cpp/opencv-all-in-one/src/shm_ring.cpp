@@ -0,0 +1,273 @@
+#include "shm_ring.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <limits>
+
+namespace {
+
+constexpr size_t kPageBytes = 4096;
+// 客户端等待时检查主机是否退出的间隔
+constexpr int kHostCheckMs = 100;
+
+size_t pageAlign(size_t n) { return (n + kPageBytes - 1) & ~(kPageBytes - 1); }
+
+/**
+ * sem_timedwait 使用 CLOCK_REALTIME 的绝对时间；timeout_ms 为负时一直等待
+ * @return false 表示超时
+ */
+bool semWait(sem_t *sem, int timeout_ms) {
+  int rc;
+  if (timeout_ms < 0) {
+    while ((rc = sem_wait(sem)) != 0 && errno == EINTR) {
+    }
+    return rc == 0;
+  }
+  timespec deadline;
+  clock_gettime(CLOCK_REALTIME, &deadline);
+  deadline.tv_sec += timeout_ms / 1000;
+  deadline.tv_nsec += static_cast<long>(timeout_ms % 1000) * 1000000;
+  if (deadline.tv_nsec >= 1000000000) {
+    deadline.tv_sec++;
+    deadline.tv_nsec -= 1000000000;
+  }
+  while ((rc = sem_timedwait(sem, &deadline)) != 0 && errno == EINTR) {
+  }
+  return rc == 0;
+}
+
+} // namespace
+
+FrameRing::FrameRing(std::string name, int fd, void *base, size_t size,
+                     bool owner, int slotCount, size_t headerBytes,
+                     size_t slotBytes)
+    : name_(std::move(name)), fd_(fd), base_(base), size_(size),
+      owner_(owner), header_(static_cast<shmHeader *>(base)),
+      slotCount_(slotCount), headerBytes_(headerBytes),
+      slotBytes_(slotBytes) {}
+
+std::unique_ptr<FrameRing> FrameRing::create(std::string const &name,
+                                             int slots, size_t slotBytes) {
+  if (slots <= 0 || slots > kShmMaxSlots || slotBytes == 0) {
+    std::fprintf(stderr, "无效的槽位设置: %d x %zu\n", slots, slotBytes);
+    return nullptr;
+  }
+  slotBytes = pageAlign(slotBytes);
+  size_t headerBytes = pageAlign(sizeof(shmHeader));
+  if (slotBytes > (std::numeric_limits<size_t>::max() - headerBytes) / slots) {
+    std::fprintf(stderr, "共享内存过大\n");
+    return nullptr;
+  }
+  size_t size = headerBytes + slotBytes * slots;
+
+  shm_unlink(name.c_str());
+  int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd < 0) {
+    std::fprintf(stderr, "shm_open %s: %s\n", name.c_str(),
+                 std::strerror(errno));
+    return nullptr;
+  }
+  void *base = MAP_FAILED;
+  if (ftruncate(fd, static_cast<off_t>(size)) == 0) {
+    base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  if (base == MAP_FAILED) {
+    std::fprintf(stderr, "映射共享内存失败: %s\n", std::strerror(errno));
+    close(fd);
+    shm_unlink(name.c_str());
+    return nullptr;
+  }
+
+  // ftruncate 得到的内存已清零，只需初始化非零字段和信号量；
+  // magic 最后写入，客户端看到 magic 时其余字段已就绪
+  auto *header = static_cast<shmHeader *>(base);
+  header->version = kShmVersion;
+  header->slotCount = static_cast<uint32_t>(slots);
+  header->slotBytes = slotBytes;
+  header->hostAlive.store(1);
+  sem_init(&header->requests, 1, 0);
+  for (int i = 0; i < slots; i++) {
+    shmSlot &s = header->slots[i];
+    sem_init(&s.done, 1, 0);
+    s.offset = headerBytes + slotBytes * i;
+  }
+  std::atomic_thread_fence(std::memory_order_release);
+  header->magic = kShmMagic;
+
+  return std::unique_ptr<FrameRing>(new FrameRing(
+      name, fd, base, size, true, slots, headerBytes, slotBytes));
+}
+
+std::unique_ptr<FrameRing> FrameRing::open(std::string const &name) {
+  int fd = shm_open(name.c_str(), O_RDWR, 0);
+  if (fd < 0) {
+    std::fprintf(stderr, "shm_open %s: %s\n", name.c_str(),
+                 std::strerror(errno));
+    return nullptr;
+  }
+  struct stat st;
+  void *base = MAP_FAILED;
+  if (fstat(fd, &st) == 0 &&
+      static_cast<size_t>(st.st_size) >= sizeof(shmHeader)) {
+    base = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+                0);
+  }
+  if (base == MAP_FAILED) {
+    std::fprintf(stderr, "%s 不是有效的帧交换区\n", name.c_str());
+    close(fd);
+    return nullptr;
+  }
+
+  auto *header = static_cast<shmHeader *>(base);
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (header->magic != kShmMagic || header->version != kShmVersion) {
+    std::fprintf(stderr, "%s 的版本不符\n", name.c_str());
+    munmap(base, st.st_size);
+    close(fd);
+    return nullptr;
+  }
+  // 映射必须容纳控制块声明的全部槽位
+  uint32_t slots = header->slotCount;
+  uint64_t slotBytes = header->slotBytes;
+  size_t headerBytes = pageAlign(sizeof(shmHeader));
+  size_t size = static_cast<size_t>(st.st_size);
+  if (slots == 0 || slots > kShmMaxSlots || slotBytes == 0 ||
+      size < headerBytes || slotBytes > (size - headerBytes) / slots) {
+    std::fprintf(stderr, "%s 不是有效的帧交换区\n", name.c_str());
+    munmap(base, st.st_size);
+    close(fd);
+    return nullptr;
+  }
+  return std::unique_ptr<FrameRing>(
+      new FrameRing(name, fd, base, size, false, static_cast<int>(slots),
+                    headerBytes, static_cast<size_t>(slotBytes)));
+}
+
+FrameRing::~FrameRing() {
+  if (owner_) {
+    // 唤醒所有等待中的客户端，它们看到 hostAlive 为0后返回失败；
+    // 信号量不销毁，仍映射着的客户端可以安全地访问
+    header_->hostAlive.store(0);
+    for (int i = 0; i < slots(); i++) {
+      sem_post(&header_->slots[i].done);
+    }
+    shm_unlink(name_.c_str());
+  }
+  munmap(base_, size_);
+  close(fd_);
+}
+
+unsigned char *FrameRing::pixels(int i) const {
+  return static_cast<unsigned char *>(base_) + headerBytes_ +
+         slotBytes_ * static_cast<size_t>(i);
+}
+
+int FrameRing::acquire() {
+  for (int i = 0; i < slots(); i++) {
+    uint32_t expected = static_cast<uint32_t>(slotState::free);
+    if (header_->slots[i].state.compare_exchange_strong(
+            expected, static_cast<uint32_t>(slotState::writing))) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+bool FrameRing::submit(int i, param const *params, int count, int width,
+                       int height, int stride) {
+  if (count < 0 || count > kShmMaxParams || (count > 0 && params == nullptr) ||
+      width <= 0 || height <= 0 || stride < width * 3 ||
+      static_cast<uint64_t>(stride) * height > slotBytes()) {
+    return false;
+  }
+  shmSlot &s = header_->slots[i];
+  s.width = width;
+  s.height = height;
+  s.stride = stride;
+  s.count = count;
+  std::copy(params, params + count, s.params);
+  s.status = -1;
+  s.sequence = header_->nextSequence.fetch_add(1);
+  s.state.store(static_cast<uint32_t>(slotState::submitted));
+  sem_post(&header_->requests);
+  return true;
+}
+
+bool FrameRing::wait(int i, int timeout_ms) {
+  // 分段等待，以便发现主机已退出；之前超时的等待可能留下多余的 post，
+  // 醒来后以槽位状态为准
+  shmSlot &s = header_->slots[i];
+  auto deadline = std::chrono::steady_clock::now() +
+                  std::chrono::milliseconds(std::max(timeout_ms, 0));
+  while (true) {
+    int chunk = kHostCheckMs;
+    if (timeout_ms >= 0) {
+      auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+          deadline - std::chrono::steady_clock::now());
+      chunk = std::clamp(static_cast<int>(left.count()), 0, kHostCheckMs);
+    }
+    bool woken = semWait(&s.done, chunk);
+    if (s.state.load() == static_cast<uint32_t>(slotState::done)) {
+      return true;
+    }
+    if (!hostAlive() || (!woken && timeout_ms >= 0 && chunk == 0)) {
+      return false;
+    }
+  }
+}
+
+void FrameRing::release(int i) {
+  header_->slots[i].state.store(static_cast<uint32_t>(slotState::free));
+}
+
+int FrameRing::next(int timeout_ms) {
+  if (!semWait(&header_->requests, timeout_ms)) {
+    return -1;
+  }
+  int best = -1;
+  for (int i = 0; i < slots(); i++) {
+    shmSlot const &s = header_->slots[i];
+    if (s.state.load() == static_cast<uint32_t>(slotState::submitted) &&
+        (best < 0 || s.sequence < header_->slots[best].sequence)) {
+      best = i;
+    }
+  }
+  if (best >= 0) {
+    header_->slots[best].state.store(
+        static_cast<uint32_t>(slotState::processing));
+  }
+  return best;
+}
+
+bool FrameRing::request(int i, shmRequest &request) const {
+  // 每个字段只读取一次，客户端之后再改写也不影响校验过的副本
+  shmSlot const &s = header_->slots[i];
+  request.width = s.width;
+  request.height = s.height;
+  request.stride = s.stride;
+  request.count = s.count;
+  if (request.count < 0 || request.count > kShmMaxParams ||
+      request.width <= 0 || request.height <= 0 ||
+      request.stride / 3 < request.width ||
+      static_cast<uint64_t>(request.stride) * request.height > slotBytes_) {
+    return false;
+  }
+  std::copy(s.params, s.params + request.count, request.params);
+  return true;
+}
+
+void FrameRing::complete(int i, int status) {
+  shmSlot &s = header_->slots[i];
+  s.status = status;
+  s.state.store(static_cast<uint32_t>(slotState::done));
+  sem_post(&s.done);
+}
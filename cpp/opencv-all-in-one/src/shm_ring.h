@@ -0,0 +1,174 @@
+#ifndef SHM_RING_H
+#define SHM_RING_H
+
+#include <interface.h>
+
+#include <semaphore.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/**
+ * 跨进程的帧交换区：一段 POSIX 共享内存，开头是控制块，之后是若干个按页
+ * 对齐的帧槽位。客户端把像素直接写入槽位并提交，主机进程在同一块内存上
+ * 原地处理，客户端再从槽位读出结果，像素不经过任何拷贝或序列化
+ *
+ * 控制通道是共享内存中的进程间信号量：每次提交 post 一次 requests 唤醒主机，
+ * 主机处理完一个槽位后 post 该槽位的 done 唤醒客户端。布局只含定长整数、
+ * 无锁原子变量和 sem_t，其他语言的客户端可以按同样的布局访问
+ */
+
+constexpr uint32_t kShmMagic = 0x4d594c42; // "MYLB"
+constexpr uint32_t kShmVersion = 1;
+constexpr int kShmMaxSlots = 64;
+constexpr int kShmMaxParams = 16;
+
+/**
+ * 槽位状态，按 free → writing → submitted → processing → done → free 循环
+ * writing 与 done 由客户端持有，processing 由主机持有
+ */
+enum class slotState : uint32_t { free, writing, submitted, processing, done };
+
+struct shmSlot {
+  std::atomic<uint32_t> state;
+  sem_t done;
+  uint64_t sequence; // 提交序号，主机按序号从小到大处理
+  uint64_t offset;   // 像素区相对共享内存起点的偏移，仅供其他客户端参考
+  int32_t width;
+  int32_t height;
+  int32_t stride;
+  int32_t count; // params 中的步骤数
+  param params[kShmMaxParams];
+  int32_t status; // processrgb_chain_into 的返回值
+};
+
+struct shmHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t slotCount;
+  uint64_t slotBytes; // 每个槽位像素区的字节数
+  std::atomic<uint32_t> hostAlive; // 主机退出时清零
+  std::atomic<uint64_t> nextSequence;
+  sem_t requests;
+  shmSlot slots[kShmMaxSlots];
+};
+
+/**
+ * 主机从槽位复制出的请求；共享内存可以被任意客户端改写，
+ * 主机只使用校验过的副本
+ */
+struct shmRequest {
+  int width;
+  int height;
+  int stride;
+  int count;
+  param params[kShmMaxParams];
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free &&
+                  std::atomic<uint64_t>::is_always_lock_free,
+              "跨进程使用的原子变量必须是无锁的");
+
+/**
+ * 帧交换区的一端；主机用 create 创建，客户端用 open 按名字连接
+ * 客户端的方法可以在多个线程中并发调用，主机的方法只能在一个线程中调用
+ */
+class FrameRing {
+public:
+  /**
+   * 创建交换区，同名的残留交换区会被替换
+   * @param name POSIX 共享内存名，以 '/' 开头
+   * @return 失败时为空，已向 stderr 输出原因
+   */
+  static std::unique_ptr<FrameRing> create(std::string const &name, int slots,
+                                           size_t slotBytes);
+
+  /**
+   * 连接已有的交换区
+   * @return 不存在或版本不符时为空，已向 stderr 输出原因
+   */
+  static std::unique_ptr<FrameRing> open(std::string const &name);
+
+  /**
+   * 断开映射；创建者同时通知客户端主机已退出并删除共享内存名
+   */
+  ~FrameRing();
+
+  FrameRing(FrameRing const &) = delete;
+  FrameRing &operator=(FrameRing const &) = delete;
+
+  int slots() const { return slotCount_; }
+  size_t slotBytes() const { return slotBytes_; }
+  bool hostAlive() const { return header_->hostAlive.load() != 0; }
+  shmSlot const &slot(int i) const { return header_->slots[i]; }
+
+  /**
+   * 槽位的像素区，至少 slotBytes 字节，按页对齐
+   * 位置由槽位下标和映射时确定的布局计算，不读取共享内存中的 offset
+   */
+  unsigned char *pixels(int i) const;
+
+  /**
+   * 客户端: 占用一个空闲槽位
+   * @return 槽位下标，全部被占用时为-1
+   */
+  int acquire();
+
+  /**
+   * 客户端: 提交已写入像素的槽位，主机将原地执行 params
+   * @return false 表示参数无效或超出槽位大小，槽位仍由客户端持有
+   */
+  bool submit(int i, param const *params, int count, int width, int height,
+              int stride);
+
+  /**
+   * 客户端: 等待提交的槽位处理完成，之后可以读取像素和 slot(i).status
+   * @param timeout_ms 负数表示一直等待
+   * @return false 表示超时或主机已退出
+   */
+  bool wait(int i, int timeout_ms);
+
+  /**
+   * 客户端: 归还槽位
+   */
+  void release(int i);
+
+  /**
+   * 主机: 取出序号最小的已提交槽位
+   * @param timeout_ms 没有提交时最多等待的毫秒数
+   * @return 槽位下标，超时为-1
+   */
+  int next(int timeout_ms);
+
+  /**
+   * 主机: 把 next 取出的槽位中的尺寸和步骤复制到 request，
+   * 并重复 submit 的检查
+   * @return false 表示槽位内容无效，应以-1完成该槽位
+   */
+  bool request(int i, shmRequest &request) const;
+
+  /**
+   * 主机: 记录处理结果并唤醒等待该槽位的客户端
+   */
+  void complete(int i, int status);
+
+private:
+  FrameRing(std::string name, int fd, void *base, size_t size, bool owner,
+            int slotCount, size_t headerBytes, size_t slotBytes);
+
+  std::string name_;
+  int fd_;
+  void *base_;
+  size_t size_;
+  bool owner_;
+  shmHeader *header_;
+  // 控制块中的布局在映射时校验并复制，之后不再从共享内存读取
+  int slotCount_;
+  size_t headerBytes_;
+  size_t slotBytes_;
+};
+
+#endif // SHM_RING_H
@@ -0,0 +1,120 @@
+#include "stats.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+/**
+ * 一个线程的计数；只有所属线程累加，读取和清零来自其他线程，
+ * 因此用原子变量，所属线程独占缓存行，没有竞争
+ */
+struct slots {
+  struct slot {
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> totalNs{0};
+    std::atomic<uint64_t> maxNs{0};
+    std::atomic<uint64_t> bytes{0};
+  };
+  slot items[kStatCount];
+
+  void addTo(statTotals (&totals)[kStatCount]) const {
+    for (int i = 0; i < kStatCount; i++) {
+      slot const &s = items[i];
+      statTotals &t = totals[i];
+      t.calls += s.calls.load(std::memory_order_relaxed);
+      t.totalNs += s.totalNs.load(std::memory_order_relaxed);
+      t.maxNs = std::max(t.maxNs, s.maxNs.load(std::memory_order_relaxed));
+      t.bytes += s.bytes.load(std::memory_order_relaxed);
+    }
+  }
+
+  void clear() {
+    for (slot &s : items) {
+      s.calls.store(0, std::memory_order_relaxed);
+      s.totalNs.store(0, std::memory_order_relaxed);
+      s.maxNs.store(0, std::memory_order_relaxed);
+      s.bytes.store(0, std::memory_order_relaxed);
+    }
+  }
+};
+
+/**
+ * 所有线程的槽位；线程退出时把自己的计数并入 retired
+ */
+struct registry {
+  std::mutex mutex;
+  std::vector<slots *> live;
+  statTotals retired[kStatCount]{};
+};
+
+registry &stats() {
+  static registry instance;
+  return instance;
+}
+
+struct threadSlots {
+  slots data;
+
+  threadSlots() {
+    registry &r = stats();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.live.push_back(&data);
+  }
+
+  ~threadSlots() {
+    registry &r = stats();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    data.addTo(r.retired);
+    r.live.erase(std::find(r.live.begin(), r.live.end(), &data));
+  }
+};
+
+slots &localSlots() {
+  thread_local threadSlots instance;
+  return instance.data;
+}
+
+} // namespace
+
+char const *statName(Stat stat) {
+  static char const *const names[kStatCount] = {
+      "processrgb",     "output_alloc",  "copy",
+      "lut",            "sharpen",       "sharpen_fixed",
+      "gaussian_blur",  "box_blur",      "saturation_hsv",
+      "saturation_rgb", "histogram",     "auto_levels",
+      "denoise",        "resample",
+  };
+  return names[static_cast<int>(stat)];
+}
+
+void recordStat(Stat stat, uint64_t ns, uint64_t bytes) {
+  slots::slot &s = localSlots().items[static_cast<int>(stat)];
+  s.calls.fetch_add(1, std::memory_order_relaxed);
+  s.totalNs.fetch_add(ns, std::memory_order_relaxed);
+  s.bytes.fetch_add(bytes, std::memory_order_relaxed);
+  uint64_t max = s.maxNs.load(std::memory_order_relaxed);
+  while (ns > max &&
+         !s.maxNs.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {
+  }
+}
+
+void readStats(statTotals (&totals)[kStatCount]) {
+  registry &r = stats();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  std::copy(std::begin(r.retired), std::end(r.retired), totals);
+  for (slots const *s : r.live) {
+    s->addTo(totals);
+  }
+}
+
+void resetStats() {
+  registry &r = stats();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  std::fill(std::begin(r.retired), std::end(r.retired), statTotals{});
+  for (slots *s : r.live) {
+    s->clear();
+  }
+}
@@ -0,0 +1,96 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <chrono>
+#include <cstdint>
+
+/**
+ * 统计的操作；外层操作的耗时包含其中调用的内层操作
+ */
+enum class Stat {
+  chain,         // processrgb 系列的一次调用、帧流中的一帧
+  outputAlloc,   // 从缓冲池分配输出
+  copy,          // 整图拷贝(无调整步骤、原地锐化的结果)
+  lut,           // 对比度/亮度查表
+  sharpen,       // filter2D 锐化
+  sharpenFixed,  // 定点锐化
+  gaussianBlur,  // GaussianBlur 模糊
+  boxBlur,       // 大 sigma 的盒式模糊
+  saturationHsv, // HSV 空间饱和度(含两次色彩空间转换)
+  saturationRgb, // RGB 空间饱和度
+  histogram,     // 自动色阶的直方图统计
+  autoLevels,    // 自动色阶查表(含合并进来的对比度/亮度)
+  denoise,       // 边缘保持降噪
+  resample,      // Lanczos-3 缩放
+  count,
+};
+
+constexpr int kStatCount = static_cast<int>(Stat::count);
+
+struct statTotals {
+  uint64_t calls;
+  uint64_t totalNs;
+  uint64_t maxNs;
+  uint64_t bytes;
+};
+
+/**
+ * 操作在 C 接口中的名称
+ */
+char const *statName(Stat stat);
+
+/**
+ * 记录一次操作，写入调用线程自己的槽位
+ */
+void recordStat(Stat stat, uint64_t ns, uint64_t bytes);
+
+/**
+ * 合并所有线程(含已退出的线程)的槽位
+ */
+void readStats(statTotals (&totals)[kStatCount]);
+
+void resetStats();
+
+#ifdef MYLIB_ENABLE_STATS
+
+/**
+ * 作用域计时，析构时记录
+ */
+class statTimer {
+public:
+  statTimer(Stat stat, uint64_t bytes)
+      : stat_(stat), bytes_(bytes), start_(std::chrono::steady_clock::now()) {}
+
+  ~statTimer() {
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start_);
+    recordStat(stat_, static_cast<uint64_t>(ns.count()), bytes_);
+  }
+
+  statTimer(statTimer const &) = delete;
+  statTimer &operator=(statTimer const &) = delete;
+
+private:
+  Stat stat_;
+  uint64_t bytes_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+#define MYLIB_STAT_CONCAT2(a, b) a##b
+#define MYLIB_STAT_CONCAT(a, b) MYLIB_STAT_CONCAT2(a, b)
+
+/**
+ * 统计从此处到所在作用域结束的耗时；关闭 MYLIB_ENABLE_STATS 时不产生任何
+ * 代码，参数也不会被求值
+ */
+#define MYLIB_TIMED(stat, bytes)                                               \
+  statTimer MYLIB_STAT_CONCAT(statTimer_, __LINE__)(                           \
+      stat, static_cast<uint64_t>(bytes))
+
+#else
+
+#define MYLIB_TIMED(stat, bytes) ((void)0)
+
+#endif
+
+#endif // STATS_H
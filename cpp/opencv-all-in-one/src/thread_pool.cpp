@@ -0,0 +1,187 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// 小于此像素数的图像不值得切分
+constexpr long long kMinParallelPixels = 256 * 256;
+constexpr int kMinStripeRows = 16;
+
+// 当前线程正在执行线程池的任务：工作线程，或 run 期间的调用线程
+// 此时的嵌套调用在本线程上顺序执行，不再尝试占用线程池
+thread_local bool tInsideWorker = false;
+
+/**
+ * 在作用域内把当前线程标记为正在执行任务，退出时恢复原值
+ */
+class InsideWorkerScope {
+public:
+  InsideWorkerScope() : saved_(tInsideWorker) { tInsideWorker = true; }
+  ~InsideWorkerScope() { tInsideWorker = saved_; }
+
+  InsideWorkerScope(InsideWorkerScope const &) = delete;
+  InsideWorkerScope &operator=(InsideWorkerScope const &) = delete;
+
+private:
+  bool saved_;
+};
+
+class ThreadPool {
+public:
+  // 默认只使用调用线程，与引入线程池之前的行为一致
+  ThreadPool() { resize(1); }
+
+  ~ThreadPool() { stop(); }
+
+  void resize(int threads) {
+    std::lock_guard<std::mutex> busy(busy_);
+    stop();
+    if (threads <= 0) {
+      threads = static_cast<int>(std::thread::hardware_concurrency());
+    }
+    threads_ = std::max(threads, 1);
+    stopping_ = false;
+    for (int i = 1; i < threads_; i++) {
+      workers_.emplace_back([this] { workerLoop(); });
+    }
+  }
+
+  int threads() const { return threads_; }
+
+  void run(int count, std::function<void(int)> const &fn) {
+    std::unique_lock<std::mutex> busy(busy_, std::defer_lock);
+    if (count <= 1 || tInsideWorker || workers_.empty() || !busy.try_lock()) {
+      for (int i = 0; i < count; i++) {
+        fn(i);
+      }
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      job_ = &fn;
+      count_ = count;
+      next_.store(0);
+      pending_ = count;
+      generation_++;
+    }
+    wake_.notify_all();
+
+    // 调用线程持有 busy_ 期间执行的任务中再调用 run，不能对 busy_ 再次 try_lock
+    InsideWorkerScope inside;
+    drain(fn, count);
+    std::unique_lock<std::mutex> lock(mutex_);
+    // 等待所有领取过本批任务的工作线程退出 drain，之后 fn 才能失效
+    done_.wait(lock, [this] { return pending_ == 0 && active_ == 0; });
+    job_ = nullptr;
+  }
+
+private:
+  void stop() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto &t : workers_) {
+      t.join();
+    }
+    workers_.clear();
+  }
+
+  // 领取并执行任务，直到当前批次全部被领取
+  void drain(std::function<void(int)> const &fn, int count) {
+    int finished = 0;
+    for (int i = next_.fetch_add(1); i < count; i = next_.fetch_add(1)) {
+      fn(i);
+      finished++;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_ -= finished;
+    if (pending_ == 0) {
+      done_.notify_all();
+    }
+  }
+
+  void workerLoop() {
+    tInsideWorker = true;
+    unsigned seen = 0;
+    for (;;) {
+      std::function<void(int)> const *fn;
+      int count;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        wake_.wait(lock,
+                   [&] { return stopping_ || (job_ && generation_ != seen); });
+        if (stopping_) {
+          return;
+        }
+        seen = generation_;
+        fn = job_;
+        count = count_;
+        active_++;
+      }
+      drain(*fn, count);
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (--active_ == 0) {
+        done_.notify_all();
+      }
+    }
+  }
+
+  std::mutex busy_; // 同一时间只有一个调用方使用工作线程
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable done_;
+  std::vector<std::thread> workers_;
+  int threads_ = 1;
+  bool stopping_ = false;
+
+  std::function<void(int)> const *job_ = nullptr;
+  unsigned generation_ = 0;
+  int count_ = 0;
+  std::atomic<int> next_{0};
+  int pending_ = 0;
+  int active_ = 0;
+};
+
+ThreadPool &pool() {
+  static ThreadPool instance;
+  return instance;
+}
+
+} // namespace
+
+void setPoolThreads(int threads) { pool().resize(threads); }
+
+int poolThreads() { return pool().threads(); }
+
+void parallelFor(int count, std::function<void(int)> const &fn) {
+  pool().run(count, fn);
+}
+
+void forEachStripe(int rows, int halo, long long pixels,
+                   std::function<void(int, int)> const &fn) {
+  int stripes = 1;
+  if (pixels >= kMinParallelPixels) {
+    int minRows = std::max(kMinStripeRows, halo * 4);
+    stripes = std::clamp(rows / minRows, 1, poolThreads());
+  }
+  if (stripes == 1) {
+    fn(0, rows);
+    return;
+  }
+
+  parallelFor(stripes, [&](int i) {
+    int begin = static_cast<int>(static_cast<long long>(rows) * i / stripes);
+    int end =
+        static_cast<int>(static_cast<long long>(rows) * (i + 1) / stripes);
+    fn(begin, end);
+  });
+}
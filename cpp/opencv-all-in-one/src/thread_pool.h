@@ -0,0 +1,35 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <functional>
+
+/**
+ * 设置并行线程数(含调用线程)
+ * @param threads 小于等于0时使用硬件线程数
+ */
+void setPoolThreads(int threads);
+
+/**
+ * 当前并行线程数(含调用线程)
+ */
+int poolThreads();
+
+/**
+ * 将任务 0..count-1 分给常驻工作线程和调用线程执行，全部完成后返回
+ * 任务内的嵌套调用(无论在工作线程还是调用线程上)、或线程池正被其他调用方
+ * 占用时，在调用线程上顺序执行
+ */
+void parallelFor(int count, std::function<void(int)> const &fn);
+
+/**
+ * 将 rows 行按水平条带切分并行处理，fn(begin, end) 处理 [begin, end) 行
+ * 条带之间不重叠；依赖邻域的滤波从相邻条带读取 halo 行，条带高度至少为
+ * halo 的4倍，以限制重复读取的比例
+ * @param rows 总行数
+ * @param halo 每个条带上下额外读取的行数(滤波核半径)，逐像素操作为0
+ * @param pixels 图像像素数，太小的图像直接在调用线程上处理
+ */
+void forEachStripe(int rows, int halo, long long pixels,
+                   std::function<void(int, int)> const &fn);
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,187 @@
+#include "video_metrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                  \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VIDEO_METRICS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+/**
+ * 一行 4x4 块的统计量，各分量分开存放
+ * 8x8 窗口内 s1、s2 ≤ 16320，ss ≤ 8.3e6，乘64后仍在 int 范围内
+ */
+struct blockRow {
+  std::vector<int> s1;  // Σa
+  std::vector<int> s2;  // Σb
+  std::vector<int> ss;  // Σa² + Σb²
+  std::vector<int> s12; // Σab
+
+  explicit blockRow(int blocks)
+      : s1(blocks), s2(blocks), ss(blocks), s12(blocks) {}
+};
+
+#if defined(VIDEO_METRICS_SSE2)
+
+/**
+ * lo、hi 中每两个相邻的32位元素相加，得到4个块的和
+ */
+inline __m128i pairSum(__m128i lo, __m128i hi) {
+  __m128 l = _mm_castsi128_ps(lo);
+  __m128 h = _mm_castsi128_ps(hi);
+  __m128i even =
+      _mm_castps_si128(_mm_shuffle_ps(l, h, _MM_SHUFFLE(2, 0, 2, 0)));
+  __m128i odd =
+      _mm_castps_si128(_mm_shuffle_ps(l, h, _MM_SHUFFLE(3, 1, 3, 1)));
+  return _mm_add_epi32(even, odd);
+}
+
+#endif
+
+/**
+ * 计算第 by 行块(图像的第 4*by 到 4*by+3 行)中每个 4x4 块的统计量
+ * SSE2 每次处理16列(4个块)：像素扩展为16位后用 madd 得到相邻两列的
+ * 和、平方和与乘积和，累加4行后再把相邻两列合成一个块
+ */
+void sumBlocks(cv::Mat const &a, cv::Mat const &b, int by, int blocks,
+               blockRow &out) {
+  uint8_t const *pa[4];
+  uint8_t const *pb[4];
+  for (int r = 0; r < 4; r++) {
+    pa[r] = a.ptr<uint8_t>(by * 4 + r);
+    pb[r] = b.ptr<uint8_t>(by * 4 + r);
+  }
+
+  int i = 0;
+#if defined(VIDEO_METRICS_SSE2)
+  __m128i const zero = _mm_setzero_si128();
+  __m128i const ones = _mm_set1_epi16(1);
+  for (; i + 4 <= blocks; i += 4) {
+    __m128i s1[2] = {zero, zero};
+    __m128i s2[2] = {zero, zero};
+    __m128i ss[2] = {zero, zero};
+    __m128i s12[2] = {zero, zero};
+    for (int r = 0; r < 4; r++) {
+      __m128i va =
+          _mm_loadu_si128(reinterpret_cast<__m128i const *>(pa[r] + i * 4));
+      __m128i vb =
+          _mm_loadu_si128(reinterpret_cast<__m128i const *>(pb[r] + i * 4));
+      __m128i wa[2] = {_mm_unpacklo_epi8(va, zero),
+                       _mm_unpackhi_epi8(va, zero)};
+      __m128i wb[2] = {_mm_unpacklo_epi8(vb, zero),
+                       _mm_unpackhi_epi8(vb, zero)};
+      for (int h = 0; h < 2; h++) {
+        s1[h] = _mm_add_epi32(s1[h], _mm_madd_epi16(wa[h], ones));
+        s2[h] = _mm_add_epi32(s2[h], _mm_madd_epi16(wb[h], ones));
+        ss[h] = _mm_add_epi32(ss[h], _mm_madd_epi16(wa[h], wa[h]));
+        ss[h] = _mm_add_epi32(ss[h], _mm_madd_epi16(wb[h], wb[h]));
+        s12[h] = _mm_add_epi32(s12[h], _mm_madd_epi16(wa[h], wb[h]));
+      }
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out.s1.data() + i),
+                     pairSum(s1[0], s1[1]));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out.s2.data() + i),
+                     pairSum(s2[0], s2[1]));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out.ss.data() + i),
+                     pairSum(ss[0], ss[1]));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out.s12.data() + i),
+                     pairSum(s12[0], s12[1]));
+  }
+#endif
+
+  for (; i < blocks; i++) {
+    int s1 = 0;
+    int s2 = 0;
+    int ss = 0;
+    int s12 = 0;
+    for (int r = 0; r < 4; r++) {
+      for (int x = i * 4; x < i * 4 + 4; x++) {
+        int va = pa[r][x];
+        int vb = pb[r][x];
+        s1 += va;
+        s2 += vb;
+        ss += va * va + vb * vb;
+        s12 += va * vb;
+      }
+    }
+    out.s1[i] = s1;
+    out.s2[i] = s2;
+    out.ss[i] = ss;
+    out.s12[i] = s12;
+  }
+}
+
+/**
+ * 一个 8x8 窗口的 SSIM，常数按64个像素缩放，整数部分与 x264 相同
+ */
+float windowSsim(int s1, int s2, int ss, int s12) {
+  constexpr int c1 = static_cast<int>(.01 * .01 * 255 * 255 * 64 + .5);
+  constexpr int c2 = static_cast<int>(.03 * .03 * 255 * 255 * 64 * 63 + .5);
+  int vars = ss * 64 - s1 * s1 - s2 * s2;
+  int covar = s12 * 64 - s1 * s2;
+  return static_cast<float>(2 * s1 * s2 + c1) *
+         static_cast<float>(2 * covar + c2) /
+         (static_cast<float>(s1 * s1 + s2 * s2 + c1) *
+          static_cast<float>(vars + c2));
+}
+
+} // namespace
+
+double ssim8x8(cv::Mat const &a, cv::Mat const &b) {
+  CV_Assert(a.type() == CV_8UC1 && b.type() == CV_8UC1 &&
+            a.size() == b.size());
+  int bw = a.cols / 4;
+  int bh = a.rows / 4;
+  if (bw < 2 || bh < 2) {
+    return 1.0;
+  }
+
+  // 上下两行块轮换使用
+  blockRow rows[2] = {blockRow(bw), blockRow(bw)};
+  sumBlocks(a, b, 0, bw, rows[0]);
+
+  double total = 0;
+  for (int by = 1; by < bh; by++) {
+    blockRow const &top = rows[(by - 1) & 1];
+    blockRow &bottom = rows[by & 1];
+    sumBlocks(a, b, by, bw, bottom);
+    // 每行块单独累加，避免整幅图像的 float 累加误差
+    float rowTotal = 0;
+    for (int i = 0; i + 1 < bw; i++) {
+      auto window = [&](std::vector<int> const &t, std::vector<int> const &u) {
+        return t[i] + t[i + 1] + u[i] + u[i + 1];
+      };
+      rowTotal += windowSsim(window(top.s1, bottom.s1),
+                             window(top.s2, bottom.s2),
+                             window(top.ss, bottom.ss),
+                             window(top.s12, bottom.s12));
+    }
+    total += rowTotal;
+  }
+  return total / (static_cast<double>(bw - 1) * (bh - 1));
+}
+
+double psnrFromMse(double mse) {
+  if (mse <= 0) {
+    return kMaxPsnr;
+  }
+  return std::min(kMaxPsnr, 10.0 * std::log10(255.0 * 255.0 / mse));
+}
+
+frameMetrics compareFrames(cv::Mat const &a, cv::Mat const &b) {
+  cv::Mat ya;
+  cv::Mat yb;
+  cv::cvtColor(a, ya, cv::COLOR_BGR2GRAY);
+  cv::cvtColor(b, yb, cv::COLOR_BGR2GRAY);
+
+  double mse = cv::norm(ya, yb, cv::NORM_L2SQR) / ya.total();
+  return frameMetrics{mse, psnrFromMse(mse), ssim8x8(ya, yb)};
+}
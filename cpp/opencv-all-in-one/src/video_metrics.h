@@ -0,0 +1,40 @@
+#ifndef VIDEO_METRICS_H
+#define VIDEO_METRICS_H
+
+#include <opencv2/opencv.hpp>
+
+// 两帧完全相同时 PSNR 记为该值，避免输出无穷大
+constexpr double kMaxPsnr = 100.0;
+
+/**
+ * 一对帧在亮度(Y，BT.601)上的质量指标
+ */
+struct frameMetrics {
+  double mse;
+  double psnr; // dB，不超过 kMaxPsnr
+  double ssim;
+};
+
+/**
+ * SSIM，窗口为 8x8 的盒式窗口、步长4(与 x264 的 --ssim 相同)
+ * 先逐列累加4行的 Σa、Σb、Σa²+Σb²、Σab，再每4列合成一个 4x4 块，
+ * 相邻 2x2 个块组成一个窗口；全部为整数运算，列循环可被编译器向量化
+ * @param a 8位单通道
+ * @param b 与 a 尺寸相同的8位单通道
+ * @return 所有窗口的平均值；图像小于 8x8 时为1
+ */
+double ssim8x8(cv::Mat const &a, cv::Mat const &b);
+
+/**
+ * 由 MSE 计算 PSNR (峰值255)
+ */
+double psnrFromMse(double mse);
+
+/**
+ * 比较两帧 BGR 图像的亮度
+ * @param a 8位三通道
+ * @param b 与 a 尺寸相同的8位三通道
+ */
+frameMetrics compareFrames(cv::Mat const &a, cv::Mat const &b);
+
+#endif // VIDEO_METRICS_H
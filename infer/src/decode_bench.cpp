@@ -0,0 +1,177 @@
+// 缩小解码的性能与精度对比
+// 用法: decode_bench [--size 224] [--iters 5] [--cache 目录] 图片...
+// 对每张图片分别测量完整解码与缩小解码(IMREAD_REDUCED_COLOR_N)加预处理的耗时，
+// 并以“完整解码 + INTER_AREA 缩放”为参考，比较两种方式结果的误差(0-255灰度级)；
+// 最后用线程池批量处理全部图片，比较两种方式的吞吐；指定 --cache 时再测量
+// 使用预处理缓存的吞吐(第一轮写入缓存，之后命中)
+#include "image_utils.h"
+#include "tensor_cache.h"
+#include "thread_pool.h"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+struct ErrorStats
+{
+    double maxAbs;
+    double meanAbs;
+};
+
+ErrorStats compare(const std::vector<float>& a, const std::vector<float>& b)
+{
+    ErrorStats stats = {0.0, 0.0};
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        double d = std::fabs(a[i] - b[i]);
+        stats.maxAbs = std::max(stats.maxAbs, d);
+        stats.meanAbs += d;
+    }
+    stats.meanAbs /= std::max<size_t>(1, a.size());
+    return stats;
+}
+
+double elapsedMs(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * 单线程处理一张图片 iters 次，返回每次的平均耗时，结果写入 out
+ */
+double timeSingle(const std::string& path, int size, int iters, bool reduced,
+                  ThreadPool& pool, std::vector<float>& out)
+{
+    std::vector<std::string> paths(1, path);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iters; i++)
+    {
+        ImageProcessor::preprocessBatch(paths, out.data(), size, size, false, reduced, &pool);
+    }
+    return elapsedMs(start) / iters;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int size = 224;
+    int iters = 5;
+    std::string cacheDir;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--size" && i + 1 < argc)
+        {
+            size = std::atoi(argv[++i]);
+        }
+        else if (arg == "--iters" && i + 1 < argc)
+        {
+            iters = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "--cache" && i + 1 < argc)
+        {
+            cacheDir = argv[++i];
+        }
+        else
+        {
+            paths.push_back(arg);
+        }
+    }
+    if (paths.empty() || size <= 0)
+    {
+        std::cerr << "Usage: decode_bench [--size 224] [--iters 5] [--cache dir] image..."
+                  << std::endl;
+        return 1;
+    }
+
+    // 单张图片的耗时只用一个工作线程，避免与批量吞吐混在一起
+    ThreadPool single(1);
+    size_t itemSize = static_cast<size_t>(size) * size * 3;
+    std::vector<float> full(itemSize);
+    std::vector<float> reduced(itemSize);
+    std::vector<float> reference(itemSize);
+    PreprocessParams identity = ImageProcessor::imagenetParams(false);
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "target " << size << "x" << size << ", " << iters << " iterations" << std::endl;
+    for (const std::string& path : paths)
+    {
+        cv::Mat image = cv::imread(path);
+        if (image.empty())
+        {
+            std::cerr << "Failed to load image: " << path << std::endl;
+            continue;
+        }
+        cv::Mat area;
+        cv::resize(image, area, cv::Size(size, size), 0, 0, cv::INTER_AREA);
+        ImageProcessor::preprocessBgrToChw(area.data, size, size, area.step, identity,
+                                           reference.data());
+
+        int factor = ImageProcessor::reducedDecodeFactor(path, size, size);
+        double fullMs = timeSingle(path, size, iters, false, single, full);
+        double reducedMs = timeSingle(path, size, iters, true, single, reduced);
+        ErrorStats fullErr = compare(full, reference);
+        ErrorStats reducedErr = compare(reduced, reference);
+
+        std::cout << "\n" << path << " (" << image.cols << "x" << image.rows
+                  << ", reduced 1/" << factor << ")" << std::endl;
+        std::cout << "  full decode:    " << fullMs << " ms, error vs INTER_AREA max "
+                  << fullErr.maxAbs << " mean " << fullErr.meanAbs << std::endl;
+        std::cout << "  reduced decode: " << reducedMs << " ms, error vs INTER_AREA max "
+                  << reducedErr.maxAbs << " mean " << reducedErr.meanAbs << std::endl;
+        std::cout << "  speedup: " << fullMs / reducedMs << "x" << std::endl;
+    }
+
+    // 批量吞吐，使用共享线程池
+    std::vector<float> batch(itemSize * paths.size());
+    std::cout << "\nbatch of " << paths.size() << " on " << ThreadPool::shared().size()
+              << " threads" << std::endl;
+    for (int reducedDecode = 0; reducedDecode < 2; reducedDecode++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iters; i++)
+        {
+            ImageProcessor::preprocessBatch(paths, batch.data(), size, size, true,
+                                            reducedDecode != 0);
+        }
+        double ms = elapsedMs(start);
+        std::cout << (reducedDecode ? "  reduced decode: " : "  full decode:    ")
+                  << paths.size() * iters * 1000.0 / ms << " images/s" << std::endl;
+    }
+
+    if (!cacheDir.empty())
+    {
+        TensorCache cache(cacheDir, 4ull << 30);
+        if (!cache.isOpen())
+        {
+            std::cerr << "Failed to open cache: " << cacheDir << std::endl;
+            return 1;
+        }
+        for (int round = 0; round < 2; round++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            int n = round == 0 ? 1 : iters;
+            for (int i = 0; i < n; i++)
+            {
+                ImageProcessor::preprocessBatch(paths, batch.data(), size, size, true, true,
+                                                nullptr, &cache);
+            }
+            double ms = elapsedMs(start);
+            std::cout << (round == 0 ? "  cache, first pass: " : "  cache, repeat:     ")
+                      << paths.size() * n * 1000.0 / ms << " images/s" << std::endl;
+        }
+        TensorCacheStats stats = cache.stats();
+        std::cout << "  cache hits " << stats.hits << ", misses " << stats.misses
+                  << ", entries " << stats.entries << ", " << stats.diskBytes / (1024 * 1024)
+                  << " MB on disk" << std::endl;
+    }
+    return 0;
+}
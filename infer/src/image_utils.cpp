@@ -1,20 +1,473 @@
 #include "image_utils.h"
+#include "tensor_cache.h"
+#include "thread_pool.h"
 #include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
 #include <iostream>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <immintrin.h>
+#define IMAGE_UTILS_SSE2 1
+// F16C 的函数单独按 AVX+F16C 编译，运行时检测到支持才调用；MSVC 不需要指定
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define IMAGE_UTILS_F16C_TARGET
+#else
+#define IMAGE_UTILS_F16C_TARGET __attribute__((target("avx,f16c")))
+#endif
+#endif
+
+namespace
+{
+// ImageNet标准化参数 (RGB顺序)
+const float kImagenetMean[3] = {0.485f, 0.456f, 0.406f};
+const float kImagenetStd[3] = {0.229f, 0.224f, 0.225f};
+
+#ifdef IMAGE_UTILS_SSE2
+/**
+ * 把48字节(16个BGR像素)拆成B、G、R三个通道各16字节
+ * 只用SSE2的解包指令(与OpenCV v_load_deinterleave的SSE2实现相同)，
+ * 每轮把三个寄存器的前后半交错一次，五轮后恢复为按通道排列
+ */
+inline void deinterleaveBgr(const unsigned char* ptr, __m128i& b, __m128i& g, __m128i& r)
+{
+    __m128i t00 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr));
+    __m128i t01 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + 16));
+    __m128i t02 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + 32));
+
+    __m128i t10 = _mm_unpacklo_epi8(t00, _mm_unpackhi_epi64(t01, t01));
+    __m128i t11 = _mm_unpacklo_epi8(_mm_unpackhi_epi64(t00, t00), t02);
+    __m128i t12 = _mm_unpacklo_epi8(t01, _mm_unpackhi_epi64(t02, t02));
+
+    __m128i t20 = _mm_unpacklo_epi8(t10, _mm_unpackhi_epi64(t11, t11));
+    __m128i t21 = _mm_unpacklo_epi8(_mm_unpackhi_epi64(t10, t10), t12);
+    __m128i t22 = _mm_unpacklo_epi8(t11, _mm_unpackhi_epi64(t12, t12));
+
+    __m128i t30 = _mm_unpacklo_epi8(t20, _mm_unpackhi_epi64(t21, t21));
+    __m128i t31 = _mm_unpacklo_epi8(_mm_unpackhi_epi64(t20, t20), t22);
+    __m128i t32 = _mm_unpacklo_epi8(t21, _mm_unpackhi_epi64(t22, t22));
+
+    b = _mm_unpacklo_epi8(t30, _mm_unpackhi_epi64(t31, t31));
+    g = _mm_unpacklo_epi8(_mm_unpackhi_epi64(t30, t30), t32);
+    r = _mm_unpacklo_epi8(t31, _mm_unpackhi_epi64(t32, t32));
+}
+
+/**
+ * 16个uint8扩展为float并乘加，结果为4组各4个
+ */
+inline void affine16(__m128i v, __m128 scale, __m128 bias, __m128 out[4])
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i lo = _mm_unpacklo_epi8(v, zero);
+    __m128i hi = _mm_unpackhi_epi8(v, zero);
+    __m128i q[4] = {
+        _mm_unpacklo_epi16(lo, zero), _mm_unpackhi_epi16(lo, zero),
+        _mm_unpacklo_epi16(hi, zero), _mm_unpackhi_epi16(hi, zero)
+    };
+    for (int i = 0; i < 4; i++)
+    {
+        out[i] = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(q[i]), scale), bias);
+    }
+}
+
+/**
+ * CPU和操作系统是否支持F16C(依赖AVX的寄存器状态)
+ */
+bool detectF16C()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    bool f16c = (info[2] & (1 << 29)) != 0;
+    return osxsave && avx && f16c && (_xgetbv(0) & 6) == 6;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c");
+#endif
+}
+
+bool hasF16C()
+{
+    static const bool supported = detectF16C();
+    return supported;
+}
+#endif
+
+/**
+ * float转IEEE半精度，就近舍入到偶数(与F16C的默认舍入相同)
+ */
+uint16_t floatToHalf(float value)
+{
+    uint32_t x;
+    std::memcpy(&x, &value, sizeof(x));
+    uint32_t sign = (x >> 16) & 0x8000;
+    uint32_t absx = x & 0x7FFFFFFF;
+    if (absx >= 0x7F800000)
+    {
+        // 无穷大保持，NaN 保留高位载荷并置为quiet
+        return static_cast<uint16_t>(sign | 0x7C00 | (absx > 0x7F800000 ? 0x200 | ((absx >> 13) & 0x3FF) : 0));
+    }
+    if (absx >= 0x477FF000)
+    {
+        return static_cast<uint16_t>(sign | 0x7C00);   // 不小于65520，舍入后溢出
+    }
+
+    uint32_t result;
+    uint32_t rem;
+    uint32_t halfway;
+    if (absx < 0x38800000)
+    {
+        // 半精度的非规格化数(小于2^-14)，单位为2^-24
+        int exponent = static_cast<int>(absx >> 23);
+        if (exponent < 102)
+        {
+            return static_cast<uint16_t>(sign);        // 小于2^-25，舍入为0
+        }
+        uint32_t mantissa = (absx & 0x7FFFFF) | 0x800000;
+        int shift = 126 - exponent;
+        result = mantissa >> shift;
+        rem = mantissa & ((1u << shift) - 1);
+        halfway = 1u << (shift - 1);
+    }
+    else
+    {
+        // 指数偏移由127改为15，尾数由23位舍入为10位，进位可以进入指数
+        uint32_t rebased = absx - 0x38000000;
+        result = rebased >> 13;
+        rem = rebased & 0x1FFF;
+        halfway = 0x1000;
+    }
+    if (rem > halfway || (rem == halfway && (result & 1)))
+    {
+        result++;
+    }
+    return static_cast<uint16_t>(sign | result);
+}
+
+// 一行BGR像素转换为三个通道平面，按输出类型重载
+
+void convertRow(const unsigned char* row, int width, const PreprocessParams& params,
+                float* r, float* g, float* b)
+{
+    int w = 0;
+#ifdef IMAGE_UTILS_SSE2
+    const __m128 scale[3] = {
+        _mm_set1_ps(params.scale[0]), _mm_set1_ps(params.scale[1]), _mm_set1_ps(params.scale[2])
+    };
+    const __m128 bias[3] = {
+        _mm_set1_ps(params.bias[0]), _mm_set1_ps(params.bias[1]), _mm_set1_ps(params.bias[2])
+    };
+    for (; w + 16 <= width; w += 16)
+    {
+        __m128i v[3];   // B、G、R
+        deinterleaveBgr(row + w * 3, v[2], v[1], v[0]);
+        float* planes[3] = {r + w, g + w, b + w};
+        for (int c = 0; c < 3; c++)
+        {
+            __m128 f[4];
+            affine16(v[c], scale[c], bias[c], f);
+            for (int i = 0; i < 4; i++)
+            {
+                _mm_storeu_ps(planes[c] + i * 4, f[i]);
+            }
+        }
+    }
+#endif
+    // 剩余不足16个的像素
+    for (; w < width; w++)
+    {
+        const unsigned char* px = row + w * 3;
+        r[w] = px[2] * params.scale[0] + params.bias[0];
+        g[w] = px[1] * params.scale[1] + params.bias[1];
+        b[w] = px[0] * params.scale[2] + params.bias[2];
+    }
+}
+
+void convertRowHalfScalar(const unsigned char* row, int width, const PreprocessParams& params,
+                          uint16_t* r, uint16_t* g, uint16_t* b)
+{
+    for (int w = 0; w < width; w++)
+    {
+        const unsigned char* px = row + w * 3;
+        r[w] = floatToHalf(px[2] * params.scale[0] + params.bias[0]);
+        g[w] = floatToHalf(px[1] * params.scale[1] + params.bias[1]);
+        b[w] = floatToHalf(px[0] * params.scale[2] + params.bias[2]);
+    }
+}
+
+#ifdef IMAGE_UTILS_SSE2
+/**
+ * 乘加后直接用 vcvtps2ph 转为半精度写出，不经过float的中间结果
+ */
+IMAGE_UTILS_F16C_TARGET
+void convertRowF16C(const unsigned char* row, int width, const PreprocessParams& params,
+                    uint16_t* r, uint16_t* g, uint16_t* b)
+{
+    const __m128 scale[3] = {
+        _mm_set1_ps(params.scale[0]), _mm_set1_ps(params.scale[1]), _mm_set1_ps(params.scale[2])
+    };
+    const __m128 bias[3] = {
+        _mm_set1_ps(params.bias[0]), _mm_set1_ps(params.bias[1]), _mm_set1_ps(params.bias[2])
+    };
+    int w = 0;
+    for (; w + 16 <= width; w += 16)
+    {
+        __m128i v[3];
+        deinterleaveBgr(row + w * 3, v[2], v[1], v[0]);
+        uint16_t* planes[3] = {r + w, g + w, b + w};
+        for (int c = 0; c < 3; c++)
+        {
+            __m128 f[4];
+            affine16(v[c], scale[c], bias[c], f);
+            for (int i = 0; i < 4; i++)
+            {
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(planes[c] + i * 4),
+                                 _mm_cvtps_ph(f[i], _MM_FROUND_TO_NEAREST_INT));
+            }
+        }
+    }
+    convertRowHalfScalar(row + w * 3, width - w, params, r + w, g + w, b + w);
+}
+#endif
+
+void convertRow(const unsigned char* row, int width, const PreprocessParams& params,
+                uint16_t* r, uint16_t* g, uint16_t* b)
+{
+#ifdef IMAGE_UTILS_SSE2
+    if (hasF16C())
+    {
+        convertRowF16C(row, width, params, r, g, b);
+        return;
+    }
+#endif
+    convertRowHalfScalar(row, width, params, r, g, b);
+}
+
+void convertRow(const unsigned char* row, int width, const PreprocessParams& /*params*/,
+                uint8_t* r, uint8_t* g, uint8_t* b)
+{
+    int w = 0;
+#ifdef IMAGE_UTILS_SSE2
+    for (; w + 16 <= width; w += 16)
+    {
+        __m128i vb, vg, vr;
+        deinterleaveBgr(row + w * 3, vb, vg, vr);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(r + w), vr);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(g + w), vg);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(b + w), vb);
+    }
+#endif
+    for (; w < width; w++)
+    {
+        const unsigned char* px = row + w * 3;
+        r[w] = px[2];
+        g[w] = px[1];
+        b[w] = px[0];
+    }
+}
+
+/**
+ * 缓存键中的输出类型
+ */
+const char* formatTag(OutputFormat format)
+{
+    switch (format)
+    {
+    case OutputFormat::Float16: return "f16";
+    case OutputFormat::Uint8: return "u8";
+    default: return "f32";
+    }
+}
+
+/**
+ * 从JPEG文件头的SOFn段读取图像尺寸，不解码
+ * 依次跳过SOF之前的各段(APPn中的EXIF缩略图可能有几十KB)，只读取段头
+ */
+bool readJpegSize(const std::string& path, int& width, int& height)
+{
+    std::ifstream file(path, std::ios::binary);
+    unsigned char soi[2];
+    if (!file.read(reinterpret_cast<char*>(soi), 2) || soi[0] != 0xFF || soi[1] != 0xD8)
+    {
+        return false;
+    }
+
+    for (;;)
+    {
+        int c = file.get();
+        if (c != 0xFF)
+        {
+            return false;
+        }
+        int marker;
+        do
+        {
+            marker = file.get();   // 标记前可以有多个0xFF填充字节
+        } while (marker == 0xFF);
+        if (marker == EOF || marker == 0xD9 || marker == 0xDA)
+        {
+            return false;          // EOI 或 SOS 之前没有找到SOF
+        }
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7))
+        {
+            continue;              // 没有长度字段的标记
+        }
+
+        unsigned char len[2];
+        if (!file.read(reinterpret_cast<char*>(len), 2))
+        {
+            return false;
+        }
+        int length = (len[0] << 8) | len[1];
+        if (length < 2)
+        {
+            return false;
+        }
+
+        // SOF0-SOF15，C4(DHT)、C8(JPG)、CC(DAC)除外
+        bool sof = marker >= 0xC0 && marker <= 0xCF &&
+                   marker != 0xC4 && marker != 0xC8 && marker != 0xCC;
+        if (sof)
+        {
+            unsigned char frame[5];   // 精度、高度、宽度
+            if (length < 7 || !file.read(reinterpret_cast<char*>(frame), 5))
+            {
+                return false;
+            }
+            height = (frame[1] << 8) | frame[2];
+            width = (frame[3] << 8) | frame[4];
+            return width > 0 && height > 0;
+        }
+        file.seekg(length - 2, std::ios::cur);
+    }
+}
+
+/**
+ * 加载BGR图像；reducedDecode 时按目标尺寸缩小解码
+ * @param factor 实际的缩小倍数，完整解码时为1
+ */
+cv::Mat loadImage(const std::string& path, int width, int height, bool reducedDecode,
+                  int& factor)
+{
+    factor = reducedDecode ? ImageProcessor::reducedDecodeFactor(path, width, height) : 1;
+    switch (factor)
+    {
+    case 8: return cv::imread(path, cv::IMREAD_REDUCED_COLOR_8);
+    case 4: return cv::imread(path, cv::IMREAD_REDUCED_COLOR_4);
+    case 2: return cv::imread(path, cv::IMREAD_REDUCED_COLOR_2);
+    default: return cv::imread(path);
+    }
+}
+
+/**
+ * 缩放到目标尺寸并写出CHW，尺寸已经相同时跳过缩放
+ * @param areaShrink 图像经过缩小解码时为 true，两个方向都缩小时改用 INTER_AREA
+ *        (按面积平均，避免混叠)，否则与原来一样使用 INTER_LINEAR
+ */
+template <OutputFormat Format>
+void preprocessMat(const cv::Mat& image, int width, int height,
+                   const PreprocessParams& params,
+                   typename OutputElement<Format>::type* dst,
+                   bool areaShrink = false)
+{
+    cv::Mat resized = image;
+    if (image.cols != width || image.rows != height)
+    {
+        bool shrink = image.cols >= width && image.rows >= height;
+        int interpolation = areaShrink && shrink ? cv::INTER_AREA : cv::INTER_LINEAR;
+        cv::resize(image, resized, cv::Size(width, height), 0, 0, interpolation);
+    }
+    ImageProcessor::preprocessBgrToChw<Format>(resized.data, width, height, resized.step,
+                                               params, dst);
+}
+
+/**
+ * 在线程池中对每个元素执行 load 得到BGR图像并预处理到 dst 的对应位置
+ * load 返回空图像或抛出异常时该元素失败，错误信息写入返回值；
+ * load 的第三个参数表示图像是否经过缩小解码，见 preprocessMat 的 areaShrink
+ * cache 不为空时先用 cacheKey 得到的键查找，命中则跳过加载和预处理，
+ * 未命中时预处理的结果写入缓存；键为空(文件不存在)时不使用缓存
+ */
+template <OutputFormat Format>
+std::vector<std::string> runBatch(
+    int count,
+    typename OutputElement<Format>::type* dst,
+    int width,
+    int height,
+    bool normalize,
+    ThreadPool* pool,
+    TensorCache* cache,
+    const std::function<std::string(int)>& cacheKey,
+    const std::function<cv::Mat(int, std::string&, bool&)>& load)
+{
+    std::vector<std::string> errors(count);
+    if (width <= 0 || height <= 0)
+    {
+        std::fill(errors.begin(), errors.end(), "Invalid target size");
+        return errors;
+    }
+
+    PreprocessParams params = ImageProcessor::imagenetParams(normalize);
+    size_t itemSize = static_cast<size_t>(width) * height * 3;
+    size_t itemBytes = itemSize * sizeof(*dst);
+    if (pool == nullptr)
+    {
+        pool = &ThreadPool::shared();
+    }
+    pool->parallelFor(count, [&](int i) {
+        typename OutputElement<Format>::type* out = dst + i * itemSize;
+        try
+        {
+            std::string key = cache != nullptr ? cacheKey(i) : std::string();
+            if (!key.empty() && cache->get(key, out, itemBytes))
+            {
+                return;
+            }
+            bool areaShrink = false;
+            cv::Mat image = load(i, errors[i], areaShrink);
+            if (!image.empty())
+            {
+                preprocessMat<Format>(image, width, height, params, out, areaShrink);
+                if (!key.empty())
+                {
+                    cache->put(key, out, itemBytes);
+                }
+                return;
+            }
+        }
+        catch (const std::exception& e)
+        {
+            errors[i] = e.what();
+        }
+        if (errors[i].empty())
+        {
+            errors[i] = "Failed to load image";
+        }
+        std::memset(out, 0, itemBytes);
+    });
+    return errors;
+}
+} // namespace
+
 std::vector<float> ImageProcessor::loadAndPreprocessImage(
     const std::string& imagePath,
     int width,
     int height, 
     int channels,
-    bool normalize)
+    bool normalize,
+    bool reducedDecode)
 {
     std::vector<float> result;
     
     try 
     {
         // 1. 加载图片
-        cv::Mat image = cv::imread(imagePath);
+        int factor = 1;
+        cv::Mat image = loadImage(imagePath, width, height, reducedDecode, factor);
         if (image.empty()) 
         {
             std::cerr << "Failed to load image: " << imagePath << std::endl;
@@ -24,20 +477,12 @@ std::vector<float> ImageProcessor::loadAndPreprocessImage(
         std::cout << "Loaded image: " << imagePath << " (" 
                   << image.cols << "x" << image.rows << ")" << std::endl;
         
-        // 2. 调整大小到目标尺寸
-        cv::Mat resized;
-        cv::resize(image, resized, cv::Size(width, height));
-        
-        // 3. 转换BGR到RGB并重排为CHW格式
-        result = bgrToRgbChw(resized.data, width, height);
-        
-        // 4. 归一化处理
-        if (normalize) 
-        {
-            normalizeImage(result);
-            // 对于ResNet，通常还需要ImageNet标准化
-            imagenetNormalize(result, channels);
-        }
+        // 2. 调整大小到目标尺寸，单遍完成BGR到RGB、CHW重排和归一化
+        //    (对于ResNet，还包括ImageNet标准化)
+        result.resize(static_cast<size_t>(width) * height * 3);
+        preprocessMat<OutputFormat::Float32>(image, width, height,
+                                             imagenetParams(normalize, channels),
+                                             result.data(), factor > 1);
         
         std::cout << "Image preprocessed successfully. Data size: " 
                   << result.size() << " elements" << std::endl;
@@ -94,10 +539,6 @@ void ImageProcessor::imagenetNormalize(std::vector<float>& data, int channels)
         return;
     }
     
-    // ImageNet标准化参数
-    const float mean[3] = {0.485f, 0.456f, 0.406f};  // RGB均值
-    const float std[3] = {0.229f, 0.224f, 0.225f};   // RGB标准差
-    
     size_t channel_size = data.size() / 3;
     
     // 对每个通道分别进行标准化: (pixel - mean) / std
@@ -106,7 +547,149 @@ void ImageProcessor::imagenetNormalize(std::vector<float>& data, int channels)
         for (size_t i = 0; i < channel_size; i++) 
         {
             size_t idx = c * channel_size + i;
-            data[idx] = (data[idx] - mean[c]) / std[c];
+            data[idx] = (data[idx] - kImagenetMean[c]) / kImagenetStd[c];
+        }
+    }
+}
+
+int ImageProcessor::reducedDecodeFactor(const std::string& imagePath, int width, int height)
+{
+    int srcWidth = 0;
+    int srcHeight = 0;
+    if (!readJpegSize(imagePath, srcWidth, srcHeight))
+    {
+        return 1;
+    }
+
+    // libjpeg 缩小后的尺寸向上取整
+    int need = std::max(width, height);
+    for (int factor = 8; factor > 1; factor /= 2)
+    {
+        int w = (srcWidth + factor - 1) / factor;
+        int h = (srcHeight + factor - 1) / factor;
+        if (std::min(w, h) >= need)
+        {
+            return factor;
+        }
+    }
+    return 1;
+}
+
+PreprocessParams ImageProcessor::imagenetParams(bool normalize, int channels)
+{
+    PreprocessParams params;
+    for (int c = 0; c < 3; c++)
+    {
+        params.scale[c] = 1.0f;
+        params.bias[c] = 0.0f;
+    }
+    if (!normalize)
+    {
+        return params;
+    }
+    if (channels != 3)
+    {
+        std::cerr << "ImageNet normalization only supports 3-channel images" << std::endl;
+        for (int c = 0; c < 3; c++)
+        {
+            params.scale[c] = 1.0f / 255.0f;
         }
+        return params;
+    }
+
+    // ((x / 255) - mean) / std = x * (1 / (255 * std)) + (-mean / std)
+    for (int c = 0; c < 3; c++)
+    {
+        params.scale[c] = 1.0f / (255.0f * kImagenetStd[c]);
+        params.bias[c] = -kImagenetMean[c] / kImagenetStd[c];
     }
-} 
\ No newline at end of file
+    return params;
+}
+
+template <OutputFormat Format>
+void ImageProcessor::preprocessBgrToChw(
+    const unsigned char* bgrData,
+    int width,
+    int height,
+    size_t step,
+    const PreprocessParams& params,
+    typename OutputElement<Format>::type* dst)
+{
+    size_t plane = static_cast<size_t>(width) * height;
+    for (int h = 0; h < height; h++)
+    {
+        size_t base = static_cast<size_t>(h) * width;
+        convertRow(bgrData + h * step, width, params,
+                   dst + base, dst + plane + base, dst + 2 * plane + base);
+    }
+}
+
+template <OutputFormat Format>
+std::vector<std::string> ImageProcessor::preprocessBatch(
+    const std::vector<std::string>& imagePaths,
+    typename OutputElement<Format>::type* dst,
+    int width,
+    int height,
+    bool normalize,
+    bool reducedDecode,
+    ThreadPool* pool,
+    TensorCache* cache)
+{
+    // 缓存键包含影响结果的全部预处理参数
+    std::string params = std::to_string(width) + "x" + std::to_string(height) +
+                         " normalize=" + (normalize ? "1" : "0") +
+                         " reduced=" + (reducedDecode ? "1" : "0") + " " + formatTag(Format);
+    auto cacheKey = [&](int i) { return TensorCache::makeKey(imagePaths[i], params); };
+    return runBatch<Format>(static_cast<int>(imagePaths.size()), dst, width, height,
+                    normalize, pool, cache, cacheKey,
+                    [&](int i, std::string& error, bool& areaShrink) {
+        int factor = 1;
+        cv::Mat image = loadImage(imagePaths[i], width, height, reducedDecode, factor);
+        areaShrink = factor > 1;
+        if (image.empty())
+        {
+            error = "Failed to load image: " + imagePaths[i];
+        }
+        return image;
+    });
+}
+
+template <OutputFormat Format>
+std::vector<std::string> ImageProcessor::preprocessBatch(
+    const std::vector<BgrImage>& images,
+    typename OutputElement<Format>::type* dst,
+    int width,
+    int height,
+    bool normalize,
+    ThreadPool* pool)
+{
+    return runBatch<Format>(static_cast<int>(images.size()), dst, width, height,
+                    normalize, pool, nullptr, nullptr,
+                    [&images](int i, std::string& error, bool&) {
+        const BgrImage& img = images[i];
+        if (img.data == nullptr || img.width <= 0 || img.height <= 0 ||
+            img.step < static_cast<size_t>(img.width) * 3)
+        {
+            error = "Invalid image buffer";
+            return cv::Mat();
+        }
+        return cv::Mat(img.height, img.width, CV_8UC3,
+                       const_cast<unsigned char*>(img.data), img.step);
+    });
+}
+
+// 三种输出类型各实例化一份，热循环在编译期按类型展开
+#define INSTANTIATE_PREPROCESS(Format)                                                        \
+    template void ImageProcessor::preprocessBgrToChw<Format>(                                 \
+        const unsigned char*, int, int, size_t, const PreprocessParams&,                      \
+        OutputElement<Format>::type*);                                                        \
+    template std::vector<std::string> ImageProcessor::preprocessBatch<Format>(                \
+        const std::vector<std::string>&, OutputElement<Format>::type*, int, int, bool, bool,  \
+        ThreadPool*, TensorCache*);                                                           \
+    template std::vector<std::string> ImageProcessor::preprocessBatch<Format>(                \
+        const std::vector<BgrImage>&, OutputElement<Format>::type*, int, int, bool,           \
+        ThreadPool*);
+
+INSTANTIATE_PREPROCESS(OutputFormat::Float32)
+INSTANTIATE_PREPROCESS(OutputFormat::Float16)
+INSTANTIATE_PREPROCESS(OutputFormat::Uint8)
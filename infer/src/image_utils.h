@@ -1,7 +1,48 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 
+class TensorCache;
+class ThreadPool;
+
+/**
+ * 预处理的逐通道仿射变换: out = pixel * scale + bias (RGB顺序)
+ * 由 /255 和 ImageNet 的 mean/std 预先合并得到，每个元素只需一次乘加
+ */
+struct PreprocessParams
+{
+    float scale[3];
+    float bias[3];
+};
+
+/**
+ * 预处理输出的元素类型，作为模板参数在编译期选择，热循环按类型各生成一份
+ */
+enum class OutputFormat
+{
+    Float32,   // float，默认
+    Float16,   // IEEE半精度(按uint16_t存储)，在归一化的同一遍中转换，传输量减半
+    Uint8      // 原始像素值，不做归一化(忽略 normalize)，供在模型内部归一化的网络使用
+};
+
+template <OutputFormat Format> struct OutputElement;
+template <> struct OutputElement<OutputFormat::Float32> { typedef float type; };
+template <> struct OutputElement<OutputFormat::Float16> { typedef uint16_t type; };
+template <> struct OutputElement<OutputFormat::Uint8> { typedef uint8_t type; };
+
+/**
+ * 已解码的BGR图像 (HWC uint8)，批量预处理的输入
+ */
+struct BgrImage
+{
+    const unsigned char* data;
+    int width;
+    int height;
+    size_t step;   // 每行字节数
+};
+
 /**
  * 图片处理工具类
  */
@@ -15,6 +56,7 @@ public:
      * @param height 目标高度 (224 for ResNet) 
      * @param channels 通道数 (3 for RGB)
      * @param normalize 是否归一化到[0,1]
+     * @param reducedDecode 是否按目标尺寸缩小解码，见 reducedDecodeFactor
      * @return 预处理后的float数据，格式为CHW (channels-height-width)
      */
     static std::vector<float> loadAndPreprocessImage(
@@ -22,8 +64,18 @@ public:
         int width = 224,
         int height = 224, 
         int channels = 3,
-        bool normalize = true
+        bool normalize = true,
+        bool reducedDecode = true
     );
+
+    /**
+     * 解码时可以使用的最大缩小倍数(1、2、4或8)
+     * 只读取JPEG文件头中的尺寸，选择缩小后宽高仍不小于目标尺寸的最大倍数，
+     * 之后由 libjpeg 在DCT阶段直接输出缩小的图像(IMREAD_REDUCED_COLOR_N)，
+     * 省去大部分解码工作；EXIF方向可能交换宽高，两种方向都要满足
+     * 不是JPEG或读取失败时为1(完整解码)
+     */
+    static int reducedDecodeFactor(const std::string& imagePath, int width, int height);
     
     /**
      * 将BGR图像转换为RGB并重排为CHW格式
@@ -51,4 +103,75 @@ public:
      * @param channels 通道数
      */
     static void imagenetNormalize(std::vector<float>& data, int channels = 3);
+
+    /**
+     * 与 normalizeImage + imagenetNormalize 等价的合并参数
+     * @param normalize 为false时不做任何变换(scale为1，bias为0)
+     * @param channels 通道数，不为3时只做 /255 (同 imagenetNormalize 的行为)
+     */
+    static PreprocessParams imagenetParams(bool normalize = true, int channels = 3);
+
+    /**
+     * 单遍完成 BGR->RGB、HWC->CHW 与归一化：读取BGR uint8，直接写出CHW
+     * 结果与 bgrToRgbChw + normalizeImage + imagenetNormalize 相差在浮点舍入以内；
+     * Float16 为同一结果就近舍入到半精度(支持F16C时用 vcvtps2ph 转换)，
+     * Uint8 只做通道重排
+     * @tparam Format 输出类型，默认 float
+     * @param bgrData BGR格式的原始数据 (HWC)
+     * @param width 图片宽度
+     * @param height 图片高度
+     * @param step 每行字节数，不小于 width * 3
+     * @param params 逐通道的仿射变换，见 imagenetParams
+     * @param dst 输出，至少 3 * width * height 个元素
+     */
+    template <OutputFormat Format = OutputFormat::Float32>
+    static void preprocessBgrToChw(
+        const unsigned char* bgrData,
+        int width,
+        int height,
+        size_t step,
+        const PreprocessParams& params,
+        typename OutputElement<Format>::type* dst
+    );
+
+    /**
+     * 批量加载图片并预处理，直接写入调用方提供的连续NCHW缓冲区
+     * (例如 cudaHostAlloc 分配的锁页内存)，不为每张图片分配结果
+     * 每张图片在线程池中独立解码、缩放和预处理；单张失败不影响其他图片，
+     * 失败的图片在缓冲区中的位置填0
+     * @tparam Format 输出类型，默认 float；Float16/Uint8 的缓冲区和拷贝量
+     *         分别为 float 的1/2和1/4
+     * @param imagePaths N个图片文件路径
+     * @param dst 输出，至少 N * 3 * height * width 个元素，第i张图片
+     *        写入 dst + i * 3 * height * width
+     * @param reducedDecode 是否按目标尺寸缩小解码，见 reducedDecodeFactor
+     * @param pool 线程池，为空时使用 ThreadPool::shared()
+     * @param cache 预处理结果的缓存，为空时不使用；命中的图片从缓存直接复制到
+     *        dst，跳过解码和预处理，未命中的图片处理后写入缓存
+     * @return N个错误信息，成功的图片对应空字符串
+     */
+    template <OutputFormat Format = OutputFormat::Float32>
+    static std::vector<std::string> preprocessBatch(
+        const std::vector<std::string>& imagePaths,
+        typename OutputElement<Format>::type* dst,
+        int width = 224,
+        int height = 224,
+        bool normalize = true,
+        bool reducedDecode = true,
+        ThreadPool* pool = nullptr,
+        TensorCache* cache = nullptr
+    );
+
+    /**
+     * 已解码图像的批量预处理，输出与错误约定同上
+     */
+    template <OutputFormat Format = OutputFormat::Float32>
+    static std::vector<std::string> preprocessBatch(
+        const std::vector<BgrImage>& images,
+        typename OutputElement<Format>::type* dst,
+        int width = 224,
+        int height = 224,
+        bool normalize = true,
+        ThreadPool* pool = nullptr
+    );
 }; 
\ No newline at end of file
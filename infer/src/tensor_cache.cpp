@@ -0,0 +1,645 @@
+#include "tensor_cache.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <direct.h>
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+const char kIndexMagic[8] = {'T', 'N', 'S', 'R', 'I', 'D', 'X', '1'};
+
+// 索引记录的类型
+const uint32_t kRecordPut = 1;     // 写入一个张量
+const uint32_t kRecordTouch = 2;   // 访问一个张量，更新最近使用
+const uint32_t kRecordDrop = 3;    // 淘汰一个数据段
+const uint32_t kRecordCreate = 4;  // 创建一个数据段
+
+// 数据段中每个张量按64字节对齐
+const uint64_t kAlignment = 64;
+
+struct IndexRecord
+{
+    uint32_t type;
+    uint32_t segment;
+    uint64_t offset;
+    uint64_t size;
+    uint64_t lastUse;
+    uint32_t keyLength;
+    uint32_t reserved;
+};
+
+bool makeDirectory(const std::string& path)
+{
+#ifdef _WIN32
+    return _mkdir(path.c_str()) == 0 || errno == EEXIST;
+#else
+    return mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+#endif
+}
+
+/**
+ * 目录中的文件名，不含 "." 和 ".."
+ */
+std::vector<std::string> listDirectory(const std::string& path)
+{
+    std::vector<std::string> names;
+#ifdef _WIN32
+    WIN32_FIND_DATAA data;
+    HANDLE find = FindFirstFileA((path + "/*").c_str(), &data);
+    if (find == INVALID_HANDLE_VALUE)
+    {
+        return names;
+    }
+    do
+    {
+        names.push_back(data.cFileName);
+    } while (FindNextFileA(find, &data));
+    FindClose(find);
+#else
+    DIR* dir = opendir(path.c_str());
+    if (dir == nullptr)
+    {
+        return names;
+    }
+    while (dirent* entry = readdir(dir))
+    {
+        names.push_back(entry->d_name);
+    }
+    closedir(dir);
+#endif
+    names.erase(std::remove_if(names.begin(), names.end(), [](const std::string& name) {
+        return name == "." || name == "..";
+    }), names.end());
+    return names;
+}
+
+/**
+ * 解析数据段文件名 seg_N.bin
+ */
+bool parseSegmentName(const std::string& name, uint32_t& id)
+{
+    const std::string prefix = "seg_";
+    const std::string suffix = ".bin";
+    if (name.size() <= prefix.size() + suffix.size() ||
+        name.compare(0, prefix.size(), prefix) != 0 ||
+        name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0)
+    {
+        return false;
+    }
+    std::string digits = name.substr(prefix.size(), name.size() - prefix.size() - suffix.size());
+    if (digits.find_first_not_of("0123456789") != std::string::npos)
+    {
+        return false;
+    }
+    id = static_cast<uint32_t>(std::strtoul(digits.c_str(), nullptr, 10));
+    return true;
+}
+
+/**
+ * 用 from 替换 to；POSIX 的 rename 本身就是原子替换，替换过程中进程退出时
+ * to 要么是旧文件要么是新文件
+ */
+bool replaceFile(const std::string& from, const std::string& to)
+{
+#ifdef _WIN32
+    return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+} // namespace
+
+/**
+ * 一个映射到内存的数据段文件；最后一个引用释放时解除映射，被淘汰的段随后删除
+ * (Windows 不能删除仍被映射的文件)
+ */
+struct TensorCache::Segment
+{
+    uint32_t id = 0;
+    std::string path;
+    unsigned char* data = nullptr;
+    uint64_t size = 0;
+    bool dropped = false;   // 已被淘汰，由 mMutex 保护
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#else
+    int fd = -1;
+#endif
+
+    /**
+     * 映射已有的数据段(create 为false，size 取文件大小)或创建 size 字节的新段
+     */
+    bool open(bool create, uint64_t createSize)
+    {
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                           create ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+        if (create)
+        {
+            size = createSize;
+        }
+        else
+        {
+            LARGE_INTEGER fileSize;
+            if (!GetFileSizeEx(file, &fileSize))
+            {
+                return false;
+            }
+            size = static_cast<uint64_t>(fileSize.QuadPart);
+        }
+        if (size == 0)
+        {
+            return false;
+        }
+        // 映射大小超过文件大小时 CreateFileMapping 会扩展文件
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE,
+                                     static_cast<DWORD>(size >> 32), static_cast<DWORD>(size), nullptr);
+        if (mapping == nullptr)
+        {
+            return false;
+        }
+        data = static_cast<unsigned char*>(MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0));
+        return data != nullptr;
+#else
+        fd = ::open(path.c_str(), create ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDWR, 0644);
+        if (fd < 0)
+        {
+            return false;
+        }
+        if (create)
+        {
+            size = createSize;
+            if (ftruncate(fd, static_cast<off_t>(size)) != 0)
+            {
+                return false;
+            }
+        }
+        else
+        {
+            struct stat st;
+            if (fstat(fd, &st) != 0)
+            {
+                return false;
+            }
+            size = static_cast<uint64_t>(st.st_size);
+        }
+        if (size == 0)
+        {
+            return false;
+        }
+        void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED)
+        {
+            return false;
+        }
+        data = static_cast<unsigned char*>(p);
+        return true;
+#endif
+    }
+
+    ~Segment()
+    {
+#ifdef _WIN32
+        if (data != nullptr)
+        {
+            UnmapViewOfFile(data);
+        }
+        if (mapping != nullptr)
+        {
+            CloseHandle(mapping);
+        }
+        if (file != INVALID_HANDLE_VALUE)
+        {
+            CloseHandle(file);
+        }
+#else
+        if (data != nullptr)
+        {
+            munmap(data, size);
+        }
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+#endif
+        if (dropped)
+        {
+            std::remove(path.c_str());
+        }
+    }
+};
+
+TensorCache::TensorCache(const std::string& directory, uint64_t capacityBytes)
+    : mDirectory(directory),
+      mCapacity(capacityBytes),
+      mIndex(nullptr),
+      mActiveUsed(0),
+      mNextSegment(0),
+      mClock(0)
+{
+    const uint64_t mb = 1024 * 1024;
+    mSegmentBytes = std::min(std::max(capacityBytes / 8, mb), 256 * mb);
+    mStats = TensorCacheStats();
+    if (capacityBytes == 0 || !makeDirectory(directory))
+    {
+        return;
+    }
+    load();
+    rewriteIndex();
+    mIndex = std::fopen((mDirectory + "/index.bin").c_str(), "ab");
+    if (mIndex == nullptr)
+    {
+        return;
+    }
+    std::fseek(mIndex, 0, SEEK_END);
+    if (std::ftell(mIndex) == 0)
+    {
+        std::fwrite(kIndexMagic, 1, sizeof(kIndexMagic), mIndex);   // 压缩索引失败时重新开始
+    }
+    evictIfNeeded();
+}
+
+TensorCache::~TensorCache()
+{
+    if (mIndex != nullptr)
+    {
+        std::fclose(mIndex);
+    }
+}
+
+std::string TensorCache::makeKey(const std::string& imagePath, const std::string& params)
+{
+#ifdef _WIN32
+    struct _stat64 st;
+    if (_stat64(imagePath.c_str(), &st) != 0)
+    {
+        return std::string();
+    }
+#else
+    struct stat st;
+    if (stat(imagePath.c_str(), &st) != 0)
+    {
+        return std::string();
+    }
+#endif
+    return imagePath + '\n' + std::to_string(static_cast<long long>(st.st_mtime)) + ' ' +
+           std::to_string(static_cast<long long>(st.st_size)) + '\n' + params;
+}
+
+bool TensorCache::get(const std::string& key, void* dst, size_t bytes)
+{
+    std::shared_ptr<Segment> segment;
+    uint64_t offset = 0;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto it = mEntries.find(key);
+        if (it == mEntries.end() || it->second.size != bytes)
+        {
+            mStats.misses++;
+            return false;
+        }
+        Entry& entry = it->second;
+        entry.lastUse = ++mClock;
+        appendRecord(kRecordTouch, entry.segment->id, &entry, key);
+        segment = entry.segment;
+        offset = entry.offset;
+        mStats.hits++;
+    }
+    // 持有数据段的引用，期间即使被淘汰也不会解除映射
+    std::memcpy(dst, segment->data + offset, bytes);
+    return true;
+}
+
+bool TensorCache::put(const std::string& key, const void* data, size_t bytes)
+{
+    if (!isOpen() || bytes == 0 || bytes > mSegmentBytes)
+    {
+        return false;
+    }
+
+    // 先在锁内预留位置，锁外复制数据，复制完成后才加入索引，
+    // 其他线程不会读到写了一半的张量
+    std::shared_ptr<Segment> segment;
+    uint64_t offset = 0;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mEntries.count(key) != 0)
+        {
+            return true;
+        }
+        if (!mActive || mActiveUsed + bytes > mActive->size)
+        {
+            if (!startSegment())
+            {
+                return false;
+            }
+        }
+        segment = mActive;
+        offset = mActiveUsed;
+        mActiveUsed += (bytes + kAlignment - 1) / kAlignment * kAlignment;
+    }
+
+    std::memcpy(segment->data + offset, data, bytes);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (segment->dropped)
+    {
+        return false;   // 复制期间所在数据段已被淘汰
+    }
+    if (mEntries.count(key) != 0)
+    {
+        return true;    // 其他线程同时写入了同一个键，预留的位置作废
+    }
+    Entry entry = {segment, offset, bytes, ++mClock};
+    mEntries[key] = entry;
+    appendRecord(kRecordPut, segment->id, &entry, key);
+    std::fflush(mIndex);
+    mStats.insertions++;
+    return true;
+}
+
+TensorCacheStats TensorCache::stats() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    TensorCacheStats result = mStats;
+    result.entries = mEntries.size();
+    result.diskBytes = 0;
+    for (const auto& item : mSegments)
+    {
+        result.diskBytes += item.second->size;
+    }
+    return result;
+}
+
+std::string TensorCache::segmentPath(uint32_t id) const
+{
+    return mDirectory + "/seg_" + std::to_string(id) + ".bin";
+}
+
+void TensorCache::load()
+{
+    struct Loaded
+    {
+        uint32_t segment;
+        uint64_t offset;
+        uint64_t size;
+        uint64_t lastUse;
+    };
+    std::unordered_map<std::string, Loaded> loaded;
+
+    // 重放索引；末尾不完整的记录(写入时进程退出)忽略
+    std::FILE* file = std::fopen((mDirectory + "/index.bin").c_str(), "rb");
+    if (file != nullptr)
+    {
+        char magic[sizeof(kIndexMagic)];
+        if (std::fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+            std::memcmp(magic, kIndexMagic, sizeof(magic)) == 0)
+        {
+            IndexRecord record;
+            std::string key;
+            while (std::fread(&record, sizeof(record), 1, file) == 1)
+            {
+                key.resize(record.keyLength);
+                if (record.keyLength > 0 && std::fread(&key[0], 1, record.keyLength, file) != record.keyLength)
+                {
+                    break;
+                }
+                mClock = std::max(mClock, record.lastUse);
+                mNextSegment = std::max(mNextSegment, record.segment + 1);
+                if (record.type == kRecordPut)
+                {
+                    Loaded entry = {record.segment, record.offset, record.size, record.lastUse};
+                    loaded[key] = entry;
+                }
+                else if (record.type == kRecordTouch)
+                {
+                    auto it = loaded.find(key);
+                    if (it != loaded.end())
+                    {
+                        it->second.lastUse = std::max(it->second.lastUse, record.lastUse);
+                    }
+                }
+                else if (record.type == kRecordDrop)
+                {
+                    for (auto it = loaded.begin(); it != loaded.end();)
+                    {
+                        it = it->second.segment == record.segment ? loaded.erase(it) : std::next(it);
+                    }
+                    std::remove(segmentPath(record.segment).c_str());
+                }
+            }
+        }
+        std::fclose(file);
+    }
+
+    // 映射被引用的数据段，打不开或张量越界时丢弃对应的张量
+    std::map<uint32_t, uint64_t> used;
+    for (const auto& item : loaded)
+    {
+        const Loaded& entry = item.second;
+        auto it = mSegments.find(entry.segment);
+        if (it == mSegments.end())
+        {
+            auto segment = std::make_shared<Segment>();
+            segment->id = entry.segment;
+            segment->path = segmentPath(entry.segment);
+            if (!segment->open(false, 0))
+            {
+                mSegments[entry.segment] = nullptr;
+                continue;
+            }
+            it = mSegments.emplace(entry.segment, segment).first;
+        }
+        if (!it->second || entry.offset + entry.size > it->second->size)
+        {
+            continue;
+        }
+        Entry live = {it->second, entry.offset, entry.size, entry.lastUse};
+        mEntries[item.first] = live;
+        used[entry.segment] = std::max(used[entry.segment], entry.offset + entry.size);
+    }
+    for (auto it = mSegments.begin(); it != mSegments.end();)
+    {
+        it = it->second ? std::next(it) : mSegments.erase(it);
+    }
+
+    // 删除索引没有引用的数据段：创建后还没有写入张量就退出的段、淘汰记录
+    // 写入前退出时留下的段、以及索引丢失时的全部段；它们不计入容量，
+    // 留着会让磁盘占用不受上限约束
+    for (const std::string& name : listDirectory(mDirectory))
+    {
+        uint32_t id = 0;
+        if (parseSegmentName(name, id) && mSegments.count(id) == 0)
+        {
+            std::remove((mDirectory + "/" + name).c_str());
+        }
+    }
+
+    // 编号最大且还有空间的数据段继续追加写入
+    if (!mSegments.empty())
+    {
+        const std::shared_ptr<Segment>& last = mSegments.rbegin()->second;
+        uint64_t end = (used[last->id] + kAlignment - 1) / kAlignment * kAlignment;
+        if (end < last->size)
+        {
+            mActive = last;
+            mActiveUsed = end;
+        }
+    }
+}
+
+void TensorCache::rewriteIndex()
+{
+    // 只保留存活张量的写入记录，写到临时文件后替换，中途退出时旧索引仍然完整
+    std::string path = mDirectory + "/index.bin";
+    std::string temp = path + ".tmp";
+    std::FILE* file = std::fopen(temp.c_str(), "wb");
+    if (file == nullptr)
+    {
+        return;
+    }
+    std::FILE* saved = mIndex;
+    mIndex = file;
+    std::fwrite(kIndexMagic, 1, sizeof(kIndexMagic), file);
+    for (const auto& item : mEntries)
+    {
+        appendRecord(kRecordPut, item.second.segment->id, &item.second, item.first);
+    }
+    mIndex = saved;
+    if (std::fclose(file) != 0)
+    {
+        std::remove(temp.c_str());
+        return;
+    }
+    if (!replaceFile(temp, path))
+    {
+        std::remove(temp.c_str());
+    }
+}
+
+bool TensorCache::startSegment()
+{
+    auto segment = std::make_shared<Segment>();
+    segment->id = mNextSegment++;
+    segment->path = segmentPath(segment->id);
+    if (!segment->open(true, mSegmentBytes))
+    {
+        segment->dropped = true;   // 删除创建了一半的文件
+        return false;
+    }
+    mSegments[segment->id] = segment;
+    mActive = segment;
+    mActiveUsed = 0;
+    appendRecord(kRecordCreate, segment->id, nullptr, std::string());
+    std::fflush(mIndex);
+    evictIfNeeded();
+    return true;
+}
+
+void TensorCache::evictIfNeeded()
+{
+    for (;;)
+    {
+        uint64_t total = 0;
+        for (const auto& item : mSegments)
+        {
+            total += item.second->size;
+        }
+        if (total <= mCapacity || mSegments.size() <= 1)
+        {
+            return;
+        }
+
+        // 数据段的最近使用取其中张量的最大值，淘汰最早的一个(正在写入的段除外)
+        std::map<uint32_t, uint64_t> recency;
+        for (const auto& item : mSegments)
+        {
+            recency[item.first] = 0;
+        }
+        for (const auto& item : mEntries)
+        {
+            uint64_t& r = recency[item.second.segment->id];
+            r = std::max(r, item.second.lastUse);
+        }
+        uint32_t victim = 0;
+        uint64_t oldest = UINT64_MAX;
+        for (const auto& item : recency)
+        {
+            if (mActive && item.first == mActive->id)
+            {
+                continue;
+            }
+            if (item.second < oldest)
+            {
+                oldest = item.second;
+                victim = item.first;
+            }
+        }
+
+        for (auto it = mEntries.begin(); it != mEntries.end();)
+        {
+            if (it->second.segment->id == victim)
+            {
+                it = mEntries.erase(it);
+                mStats.evictions++;
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        appendRecord(kRecordDrop, victim, nullptr, std::string());
+        if (mIndex != nullptr)
+        {
+            std::fflush(mIndex);
+        }
+        // 仍在复制数据的线程持有引用，最后一个引用释放时删除文件
+        mSegments[victim]->dropped = true;
+        mSegments.erase(victim);
+    }
+}
+
+void TensorCache::appendRecord(uint32_t type, uint32_t segment, const Entry* entry,
+                               const std::string& key)
+{
+    if (mIndex == nullptr)
+    {
+        return;
+    }
+    IndexRecord record = {};
+    record.type = type;
+    record.segment = segment;
+    if (entry != nullptr)
+    {
+        record.offset = entry->offset;
+        record.size = entry->size;
+        record.lastUse = entry->lastUse;
+    }
+    record.keyLength = static_cast<uint32_t>(key.size());
+    std::fwrite(&record, sizeof(record), 1, mIndex);
+    std::fwrite(key.data(), 1, key.size(), mIndex);
+}
@@ -0,0 +1,110 @@
+#ifndef TENSOR_CACHE_H
+#define TENSOR_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/**
+ * 缓存的命中统计
+ */
+struct TensorCacheStats
+{
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t insertions;
+    uint64_t evictions;   // 被淘汰的张量数
+    uint64_t entries;     // 当前缓存的张量数
+    uint64_t diskBytes;   // 数据段文件占用的字节数
+};
+
+/**
+ * 预处理结果的持久化缓存，用同一批图片反复测试不同引擎时跳过解码和预处理
+ *
+ * 目录中的数据段文件(seg_N.bin)大小固定，整体映射到内存，张量只追加写入；
+ * 索引文件(index.bin)只追加记录写入、访问和淘汰，打开时重放并压缩
+ * 命中时从映射直接复制到调用方的缓冲区(例如batch缓冲区)，不经过read和中间缓冲
+ * 总大小超过上限时按数据段淘汰：丢弃最近一次访问最早的数据段及其中的全部张量
+ *
+ * 线程安全；同一目录同一时间只能由一个进程打开
+ */
+class TensorCache
+{
+public:
+    /**
+     * 打开或创建缓存目录
+     * @param directory 缓存目录，不存在时创建(只创建最后一级)
+     * @param capacityBytes 数据段文件的总大小上限，每个数据段为上限的1/8
+     *        (1MB-256MB)，单个张量不能超过一个数据段
+     */
+    TensorCache(const std::string& directory, uint64_t capacityBytes);
+    ~TensorCache();
+
+    TensorCache(const TensorCache&) = delete;
+    TensorCache& operator=(const TensorCache&) = delete;
+
+    /**
+     * 目录是否成功打开，失败时 get 总是未命中、put 总是失败
+     */
+    bool isOpen() const { return mIndex != nullptr; }
+
+    /**
+     * 由图片路径、修改时间、文件大小和预处理参数组成的键，文件被修改后键随之改变
+     * @param params 预处理参数的文本描述，参数不同的结果互不混用
+     * @return 键，文件不存在时为空字符串
+     */
+    static std::string makeKey(const std::string& imagePath, const std::string& params);
+
+    /**
+     * 查找并复制到 dst
+     * @param bytes dst 的大小，与缓存的张量大小不同时视为未命中
+     * @return 是否命中
+     */
+    bool get(const std::string& key, void* dst, size_t bytes);
+
+    /**
+     * 写入张量，键已存在时不做任何事
+     * @return 是否成功写入或已存在
+     */
+    bool put(const std::string& key, const void* data, size_t bytes);
+
+    TensorCacheStats stats() const;
+
+private:
+    struct Segment;
+    struct Entry
+    {
+        std::shared_ptr<Segment> segment;
+        uint64_t offset;
+        uint64_t size;
+        uint64_t lastUse;
+    };
+
+    void load();
+    void rewriteIndex();
+    bool startSegment();
+    void evictIfNeeded();
+    void appendRecord(uint32_t type, uint32_t segment, const Entry* entry, const std::string& key);
+    std::string segmentPath(uint32_t id) const;
+
+    std::string mDirectory;
+    uint64_t mCapacity;
+    uint64_t mSegmentBytes;
+
+    mutable std::mutex mMutex;
+    std::FILE* mIndex;
+    std::unordered_map<std::string, Entry> mEntries;
+    std::map<uint32_t, std::shared_ptr<Segment>> mSegments;
+    std::shared_ptr<Segment> mActive;   // 正在追加写入的数据段
+    uint64_t mActiveUsed;
+    uint32_t mNextSegment;
+    uint64_t mClock;                    // 访问计数，代替时间戳记录最近使用
+    TensorCacheStats mStats;
+};
+
+#endif // TENSOR_CACHE_H
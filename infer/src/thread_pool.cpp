@@ -0,0 +1,119 @@
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace
+{
+/**
+ * 一次 parallelFor 的共享状态；晚于所有元素领取完才开始执行的任务
+ * 仍会访问它，因此由 shared_ptr 持有
+ */
+struct ForState
+{
+    std::function<void(int)> fn;
+    int count;
+    std::atomic<int> next{0};
+    std::atomic<int> done{0};
+    std::mutex mutex;
+    std::condition_variable finished;
+
+    // 领取并执行元素，直到全部领取完
+    void run()
+    {
+        int i;
+        while ((i = next.fetch_add(1)) < count)
+        {
+            fn(i);
+            if (done.fetch_add(1) + 1 == count)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                finished.notify_all();
+            }
+        }
+    }
+};
+} // namespace
+
+ThreadPool::ThreadPool(int threads)
+    : mStop(false)
+{
+    if (threads <= 0)
+    {
+        threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+    for (int i = 0; i < threads; i++)
+    {
+        mWorkers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+    }
+    mCondition.notify_all();
+    for (std::thread& worker : mWorkers)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int)>& fn)
+{
+    if (count <= 0)
+    {
+        return;
+    }
+
+    auto state = std::make_shared<ForState>();
+    state->fn = fn;
+    state->count = count;
+
+    // 调用线程也领取元素，因此最多再需要 count - 1 个工作线程
+    int helpers = std::min(size(), count - 1);
+    if (helpers > 0)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            for (int i = 0; i < helpers; i++)
+            {
+                mTasks.emplace_back([state]() { state->run(); });
+            }
+        }
+        mCondition.notify_all();
+    }
+
+    // 等待的是元素全部完成，而不是任务全部执行：嵌套调用时工作线程
+    // 都在等待，排队的任务可能一直轮不到，调用线程会把剩余元素做完
+    state->run();
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished.wait(lock, [&state]() { return state->done.load() == state->count; });
+}
+
+ThreadPool& ThreadPool::shared()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::workerLoop()
+{
+    for (;;)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [this]() { return mStop || !mTasks.empty(); });
+            if (mStop && mTasks.empty())
+            {
+                return;
+            }
+            task = std::move(mTasks.front());
+            mTasks.pop_front();
+        }
+        task();
+    }
+}
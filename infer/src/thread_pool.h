@@ -0,0 +1,54 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * 固定数量工作线程的线程池，用于批量预处理等按元素并行的任务
+ */
+class ThreadPool
+{
+public:
+    /**
+     * @param threads 工作线程数，小于等于0时使用硬件线程数
+     */
+    explicit ThreadPool(int threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * 工作线程数
+     */
+    int size() const { return static_cast<int>(mWorkers.size()); }
+
+    /**
+     * 对 [0, count) 中的每个 i 执行 fn(i)，全部完成后返回
+     * 元素由工作线程和调用线程动态领取，耗时不均时也能均衡；
+     * 可以被多个线程同时调用，也可以在 fn 中嵌套调用
+     * fn 不能抛出异常
+     */
+    void parallelFor(int count, const std::function<void(int)>& fn);
+
+    /**
+     * 进程共享的线程池，首次使用时按硬件线程数创建
+     */
+    static ThreadPool& shared();
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> mWorkers;
+    std::deque<std::function<void()>> mTasks;
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    bool mStop;
+};
+
+#endif // THREAD_POOL_H